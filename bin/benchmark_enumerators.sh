@@ -0,0 +1,15 @@
+#!/bin/bash
+# Times how fast each subset enumerator (--order) lists the subsets of some representative workunits, without testing
+# them.  Any arguments are passed on to g++.
+cd ../client/
+g++ -Wall -O3 -DENUMERATION_BENCHMARK "$@" subset_sum_main.cpp -o ../bin/subset_sum_enumeration_benchmark || exit 1
+cd ../bin/
+
+WORKUNITS=("50 7" "100 6 0 50000000" "200 5 0 50000000" "700 4 0 50000000" "3000 3")
+
+for workunit in "${WORKUNITS[@]}"; do
+    echo "$workunit:"
+    ./subset_sum_enumeration_benchmark $workunit 2>&1 > /dev/null | grep subsets
+done
+
+rm -f subset_sum_enumeration_benchmark
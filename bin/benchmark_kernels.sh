@@ -0,0 +1,21 @@
+#!/bin/bash
+# Times each kernel used to test subsets, and the whole of testing a subset, on a grid of workunits, and prints the
+# results as tab separated values (with the g++ arguments in the first column) so builds can be compared, eg:
+#   ./benchmark_kernels.sh > default.tsv
+#   ./benchmark_kernels.sh -DSUMS_WORD_32 > word_32.tsv
+# Any arguments are passed on to g++.
+cd ../client/
+g++ -Wall -O3 -DKERNEL_BENCHMARK "$@" subset_sum_main.cpp -o ../bin/subset_sum_kernel_benchmark || exit 1
+cd ../bin/
+
+WORKUNITS=("40 6" "50 7 0 5000000" "100 6 0 5000000" "200 5 0 5000000" "700 4 0 2000000" "3000 3 0 1000000")
+BUILD="$*"
+
+rm -f kernel_benchmark.tsv
+for workunit in "${WORKUNITS[@]}"; do
+    ./subset_sum_kernel_benchmark $workunit > /dev/null 2>&1 || exit 1
+done
+
+awk -v build="${BUILD:-default}" 'BEGIN { FS = OFS = "\t" } { print (NR == 1) ? "build" : build, $0 }' kernel_benchmark.tsv
+
+rm -f subset_sum_kernel_benchmark kernel_benchmark.tsv
@@ -0,0 +1,22 @@
+#!/bin/bash
+# Times the lexicographic (sums bitsets) and revolving door (sum counts) orders on some representative workunits.
+# Any arguments are passed on to g++, eg: ./benchmark_orders.sh -DNO_LAST_ELEMENT_SWEEP
+cd ../client/
+g++ -Wall -O3 "$@" subset_sum_main.cpp -o ../bin/subset_sum_benchmark || exit 1
+cd ../bin/
+
+WORKUNITS=("50 7" "100 6 0 5000000" "200 5 0 5000000" "700 4 0 5000000" "3000 3 0 2000000")
+
+printf "%-22s %14s %14s\n" "workunit" "lexicographic" "revolving_door"
+for workunit in "${WORKUNITS[@]}"; do
+    printf "%-22s" "$workunit"
+    for order in lexicographic revolving_door; do
+        start=$(date +%s.%N)
+        ./subset_sum_benchmark --order $order $workunit > /dev/null 2>&1
+        end=$(date +%s.%N)
+        printf " %13.2fs" $(echo "$start $end" | awk '{print $2 - $1}')
+    done
+    printf "\n"
+done
+
+rm -f subset_sum_benchmark
@@ -0,0 +1,15 @@
+#!/bin/bash
+# Times how many jobs per second the work generator's job creation makes, one job at a time and in batches, against
+# a SQLite stand-in for the BOINC database (see server/benchmark_job_creation.cpp), eg:
+#   ./benchmark_work_generator.sh 5000
+# The first argument is how many jobs to make with each batch size (2000 by default).
+cd ../server/
+g++ -Wall -O2 benchmark_job_creation.cpp -o ../bin/benchmark_job_creation -lsqlite3 || exit 1
+cd ../bin/
+
+JOBS=${1:-2000}
+SCRATCH=$(mktemp -d) || exit 1
+
+./benchmark_job_creation "$SCRATCH/jobs.db" "$SCRATCH" "$JOBS" 1 10 100 1000
+
+rm -rf "$SCRATCH" benchmark_job_creation
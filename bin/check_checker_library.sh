@@ -0,0 +1,162 @@
+#!/bin/bash
+# Checks client/subset_sum_checker.hpp can be used as a library: two files which both include it (and so subset_ranks.hpp,
+# shift_or.hpp and run_stats.hpp) are compiled with -Werror, with and without -DRUN_STATS, linked together, and the
+# counts they get for each order compared with the client's.  Two files which both include failed_set_records.hpp (and
+# so subset_output.hpp) are also built, with and without -DHTML_OUTPUT and -DENABLE_COLOR, and one reads back the
+# records the other wrote, and prints bits with the tables the other made, eg:
+#   ./check_checker_library.sh 30 5
+# The arguments are the M and N to test (30 and 5 by default).
+M=${1:-30}
+N=${2:-5}
+SCRATCH=$(mktemp -d) || exit 1
+
+cat > "$SCRATCH/check_range.cpp" <<'END'
+#include "subset_sum_checker.hpp"
+
+struct counting_sink : subset_sink {
+    unsigned long long failed;
+
+    counting_sink() : failed(0) {
+    }
+
+    void tested_subset(const subset_rank_t rank, const unsigned int *subset, const unsigned int subset_size, const bool success) {
+        if (!success) failed++;
+    }
+};
+
+subset_counts check_range(const subset_order order, const unsigned int M, const unsigned int N, unsigned long long &failed) {
+    subset_sum_checker checker;
+    new_subset_sum_checker(checker, M, N);
+
+    counting_sink sink;
+    subset_range range = { order, 0, (unsigned long long)n_choose_k(M - 1, N - 1) };
+    subset_counts counts = check_subsets(checker, range, sink);
+
+    delete_subset_sum_checker(checker);
+    failed = sink.failed;
+    return counts;
+}
+END
+
+cat > "$SCRATCH/main.cpp" <<'END'
+#include <cstdio>
+#include <cstdlib>
+
+#include "subset_sum_checker.hpp"
+
+subset_counts check_range(const subset_order order, const unsigned int M, const unsigned int N, unsigned long long &failed);
+
+int main(int argc, char **argv) {
+    unsigned int M = atoi(argv[1]);
+    unsigned int N = atoi(argv[2]);
+
+    init_binomials(M - 1, N - 1);
+    select_shift_or_kernel();
+
+    for (unsigned int order = 0; order < SUBSET_ORDERS; order++) {
+        unsigned long long failed;
+        subset_counts counts = check_range((subset_order)order, M, N, failed);
+        if (failed != counts.fail) {
+            fprintf(stderr, "%s: %llu failed sets were reported, but %llu failed.\n", subset_order_names[order], failed, counts.fail);
+            return 1;
+        }
+        printf("%llu total sets, %llu sets passed, %llu sets failed\n", counts.pass + counts.fail, counts.pass, counts.fail);
+    }
+    return 0;
+}
+END
+
+cat > "$SCRATCH/write_records.cpp" <<'END'
+#include "failed_set_records.hpp"
+
+void write_records(FILE *output) {
+    failed_set_header header = { FAILED_SET_MISSING_SUMS, 0, 30, 5, 0, 0 };
+    write_failed_set_header(output, header);
+
+    std::vector<missing_sums> missing;
+    missing_sums range = { 31, 33 };
+    missing.push_back(range);
+
+    result_buffer results;
+    new_result_buffer(results, output);
+    append_failed_set(results, 7, 30, &missing);
+    delete_result_buffer(results);
+
+    write_failed_set_end(output, 10, 1);
+}
+
+void print_byte(result_buffer &results, const unsigned char byte) {
+    print_bits(results, byte);
+}
+END
+
+cat > "$SCRATCH/read_records.cpp" <<'END'
+#include "failed_set_records.hpp"
+
+void write_records(FILE *output);
+void print_byte(result_buffer &results, const unsigned char byte);
+
+int main(int argc, char **argv) {
+    init_bit_characters();
+    init_report_widths(30, 1000);
+
+    FILE *file = tmpfile();
+    write_records(file);
+    rewind(file);
+
+    failed_set_header header;
+    failed_set_record failed, end;
+    if (!read_failed_set_header(file, header) || !read_failed_set_record(file, header, failed) || !read_failed_set_record(file, header, end)
+            || failed.type != FAILED_SET_RECORD || failed.rank_offset != 7 || failed.missing.size() != 1 || failed.missing[0].first != 31 || failed.missing[0].last != 33
+            || end.type != FAILED_SET_END || end.pass != 10 || end.fail != 1) {
+        fprintf(stderr, "the records read back aren't the ones written.\n");
+        return 1;
+    }
+
+    result_buffer results;
+    new_result_buffer(results, stdout);
+    print_byte(results, 0xA5);
+    append_char(results, '\n');
+    delete_result_buffer(results);
+    return 0;
+}
+END
+
+cd ../client/
+g++ -Wall -O2 subset_sum_main.cpp -o "$SCRATCH/subset_sum" || exit 1
+EXPECTED=$("$SCRATCH/subset_sum" "$M" "$N" 2>/dev/null | grep "total sets" | sed 's/, [0-9.]* success rate\.//')
+
+STATUS=0
+for FLAGS in "" "-DRUN_STATS"; do
+    if ! g++ -Wall -Werror -O2 $FLAGS -I. "$SCRATCH/check_range.cpp" "$SCRATCH/main.cpp" -o "$SCRATCH/checker_library"; then
+        echo "FAILED to build two files including subset_sum_checker.hpp with '$FLAGS'"
+        STATUS=1
+        continue
+    fi
+
+    for ORDER in lexicographic jun_liu revolving_door; do
+        read -r LINE
+        if [ "$LINE" != "$EXPECTED" ]; then
+            echo "FAILED ($FLAGS, $ORDER): got '$LINE', the client got '$EXPECTED'"
+            STATUS=1
+        fi
+    done < <("$SCRATCH/checker_library" "$M" "$N")
+done
+
+for FLAGS in "" "-DHTML_OUTPUT" "-DENABLE_COLOR" "-DENABLE_COLOR -DHTML_OUTPUT"; do
+    if ! g++ -Wall -Werror -O2 $FLAGS -I. "$SCRATCH/write_records.cpp" "$SCRATCH/read_records.cpp" -o "$SCRATCH/records_library"; then
+        echo "FAILED to build two files including failed_set_records.hpp with '$FLAGS'"
+        STATUS=1
+        continue
+    fi
+
+    LINE=$("$SCRATCH/records_library")
+    if [ "$LINE" != "10100101" ]; then
+        echo "FAILED ($FLAGS): the records or bit characters weren't shared between the files, got '$LINE'"
+        STATUS=1
+    fi
+done
+
+rm -rf "$SCRATCH"
+[ $STATUS = 0 ] && echo "subset_sum_checker.hpp and failed_set_records.hpp build and link from two files, and the checker matches the client for $M $N."
+exit $STATUS
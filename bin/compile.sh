@@ -1,7 +1,9 @@
 cd ../client/
 #g++ -Wall -O3 -msse3 -funroll-loops -ftree-vectorize subset_sum_main.cpp -o ../bin/subset_sum
 g++ -Wall -DVERBOSE -DFALSE_ONLY -DHTML_OUTPUT -DENABLE_COLOR -O3 -msse3 -funroll-loops -ftree-vectorize subset_sum_main.cpp -o ../bin/subset_sum
-#g++ -Wall -DVERBOSE -DENABLE_CHECKPOINTING -DENABLE_COLOR -O3 -msse3 -funroll-loops -ftree-vectorize subset_sum_main.cpp -o ../bin/subset_sum
-#g++ -Wall -DVERBOSE -DHTML_OUTPUT -DENABLE_CHECKPOINTING -DENABLE_COLOR -O3 -msse3 -funroll-loops -ftree-vectorize subset_sum_main.cpp -o ../bin/subset_sum
-#g++ -Wall -DVERBOSE -DENABLE_CHECKPOINTING -DENABLE_COLOR -DFALSE_ONLY -O3 -msse3 -funroll-loops -ftree-vectorize subset_sum_main.cpp -o ../bin/subset_sum
+#g++ -Wall -DVERBOSE -DENABLE_CHECKPOINTING -DENABLE_COLOR -O3 -msse3 -funroll-loops -ftree-vectorize -pthread subset_sum_main.cpp -o ../bin/subset_sum
+#g++ -Wall -DVERBOSE -DHTML_OUTPUT -DENABLE_CHECKPOINTING -DENABLE_COLOR -O3 -msse3 -funroll-loops -ftree-vectorize -pthread subset_sum_main.cpp -o ../bin/subset_sum
+#g++ -Wall -DVERBOSE -DENABLE_CHECKPOINTING -DENABLE_COLOR -DFALSE_ONLY -O3 -msse3 -funroll-loops -ftree-vectorize -pthread subset_sum_main.cpp -o ../bin/subset_sum
+#g++ -Wall -DBINARY_OUTPUT -O3 subset_sum_main.cpp -o ../bin/subset_sum
+g++ -Wall -DHTML_OUTPUT -DENABLE_COLOR -O3 render_failed_sets.cpp -o ../bin/render_failed_sets
 cd ../bin/
@@ -0,0 +1,12 @@
+#!/bin/bash
+# Simulates a problem on hosts of mixed speeds, with and without splitting late slices (see
+# server/simulate_stragglers.cpp), eg:
+#   ./simulate_stragglers.sh --hosts 500 --slices 10000 --runs 5
+# The arguments are passed on to simulate_stragglers.
+cd ../server/
+g++ -Wall -O2 simulate_stragglers.cpp -o ../bin/simulate_stragglers || exit 1
+cd ../bin/
+
+./simulate_stragglers "$@"
+
+rm -f simulate_stragglers
@@ -0,0 +1,268 @@
+#!/bin/bash
+# Builds server/sss_work_generator.cpp against stand-ins for the BOINC server headers (written to a scratch directory,
+# so it can be run without a BOINC tree), and runs it on a small problem until every slice has been made, checking:
+#   - the workunits inserted and their input files cover the subsets once each, in order,
+#   - "Every slice has been made" is logged once, however many more times it polls,
+#   - a restart carries on from the state file and makes nothing more,
+#   - a batch whose insert fails is rolled back, and a restart makes the rest of the slices once each.
+# eg:
+#   ./smoke_test_work_generator.sh 50 6
+# The arguments are the M and N of the problem (40 and 6 by default).
+M=${1:-40}
+N=${2:-6}
+SCRATCH=$(mktemp -d) || exit 1
+mkdir -p "$SCRATCH/boinc" "$SCRATCH/project/templates" "$SCRATCH/project/download"
+
+for HEADER in backend_lib.h error_numbers.h parse.h util.h svn_version.h sched_config.h sched_util.h sched_msgs.h str_util.h; do
+    touch "$SCRATCH/boinc/$HEADER"
+done
+
+# The stand-ins: the project directory is $STUB_PROJECT, every job is sent as soon as it is made (so there are never
+# any unsent), workunits are appended to $STUB_PROJECT/workunits (one name a line), and the generator stops after
+# $STUB_POLLS polls.
+cat > "$SCRATCH/boinc/boinc_db.h" <<'END'
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <string>
+
+#define MAX_QUERY_LEN 262144
+#define ERR_DB_NOT_FOUND -136
+#define ERR_FOPEN -108
+#define ERR_FWRITE -103
+#define ERR_RENAME -110
+#define MSG_CRITICAL 1
+#define MSG_NORMAL 2
+#define MSG_DEBUG 3
+#define SVN_VERSION "smoke test"
+
+struct SCHED_MSG_LOG {
+    void printf(int kind, const char *format, ...) {
+        va_list arguments;
+        va_start(arguments, format);
+        vfprintf(stderr, format, arguments);
+        va_end(arguments);
+    }
+
+    void set_debug_level(int level) {
+    }
+};
+static SCHED_MSG_LOG log_messages;
+static bool g_print_queries;
+
+struct SCHED_CONFIG {
+    char db_name[16], db_host[16], db_user[16], db_passwd[16];
+
+    int parse_file() {
+        return 0;
+    }
+
+    const char* project_path(const char *file) {
+        static char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", getenv("STUB_PROJECT"), file);
+        return path;
+    }
+
+    int download_path(const char *name, char *path) {
+        std::string full = std::string(getenv("STUB_PROJECT")) + "/download/" + name;
+        strncpy(path, full.c_str(), 255);
+        path[255] = '\0';
+        return 0;
+    }
+};
+static SCHED_CONFIG config;
+
+// Rows inserted in a transaction are only added to the workunits file when it is committed.  A transaction still open
+// when the generator exits is noted in $STUB_PROJECT/open_transactions, and each rollback in $STUB_PROJECT/rollbacks.
+struct DB_CONN {
+    bool in_transaction;
+    std::string pending;
+
+    DB_CONN() : in_transaction(false) {
+    }
+
+    ~DB_CONN() {
+        if (in_transaction) note("open_transactions");
+    }
+
+    void note(const char *file) {
+        FILE *notes = fopen(config.project_path(file), "a");
+        fprintf(notes, "%s\n", file);
+        fclose(notes);
+    }
+
+    int open(const char *name, const char *host, const char *user, const char *password) {
+        return 0;
+    }
+
+    int start_transaction() {
+        in_transaction = true;
+        pending.clear();
+        return 0;
+    }
+
+    int commit_transaction() {
+        FILE *file = fopen(config.project_path("workunits"), "a");
+        fputs(pending.c_str(), file);
+        fclose(file);
+        pending.clear();
+        in_transaction = false;
+        return 0;
+    }
+
+    int rollback_transaction() {
+        note("rollbacks");
+        pending.clear();
+        in_transaction = false;
+        return 0;
+    }
+};
+static DB_CONN boinc_db;
+
+struct DB_APP {
+    int id;
+
+    int lookup(const char *where) {
+        id = 1;
+        return 0;
+    }
+};
+
+struct DB_WORKUNIT {
+    int appid;
+    char name[256];
+    double rsc_fpops_est, rsc_fpops_bound, rsc_memory_bound, rsc_disk_bound;
+    int delay_bound, min_quorum, target_nresults, max_error_results, max_total_results, max_success_results;
+
+    void clear() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    // The rows are the names of the workunits, in brackets (see create_work).
+    // The insert numbered $STUB_FAIL_INSERT (if it is set) fails.
+    int insert_batch(std::string &values) {
+        static int inserts = 0;
+        const char *fail = getenv("STUB_FAIL_INSERT");
+        if (fail != NULL && ++inserts == atoi(fail)) return -1;
+
+        for (size_t start = values.find('('); start != std::string::npos; start = values.find('(', start + 1)) {
+            boinc_db.pending += values.substr(start + 1, values.find(')', start) - start - 1) + "\n";
+        }
+        return 0;
+    }
+
+    int lookup(const char *where) {
+        char name[256], line[256];
+        if (sscanf(where, "where name='%255[^']'", name) != 1) return ERR_DB_NOT_FOUND;
+
+        FILE *file = fopen(config.project_path("workunits"), "r");
+        if (file == NULL) return ERR_DB_NOT_FOUND;
+        bool found = false;
+        while (!found && fscanf(file, "%255s", line) == 1) found = !strcmp(line, name);
+        fclose(file);
+        return found ? 0 : ERR_DB_NOT_FOUND;
+    }
+
+    int count(int &n, const char *where) {
+        n = 0;
+        return 0;
+    }
+};
+
+inline int create_work(DB_WORKUNIT &wu, const char *in_template, const char *result_template_filename, const char *result_template_filepath, const char **infiles, int ninfiles, SCHED_CONFIG &config, const char *command_line, const char *additional_xml, char *value_buf) {
+    sprintf(value_buf, "(%s)", wu.name);
+    return 0;
+}
+
+inline int count_unsent_results(int &n, int appid) {
+    n = 0;
+    return 0;
+}
+
+inline void check_stop_daemons() {
+    static int polls = 0;
+    if (++polls > atoi(getenv("STUB_POLLS"))) exit(0);
+}
+
+inline double dtime() {
+    static double now = 0;
+    return now += 60;
+}
+
+inline void boinc_sleep(double seconds) {
+}
+
+inline int read_file_malloc(const char *path, char *&contents) {
+    contents = strdup("");
+    return 0;
+}
+
+inline const char* boincerror(int retval) {
+    return "stub error";
+}
+
+inline bool is_arg(const char *argument, const char *name) {
+    if (argument[0] != '-') return false;
+    if (argument[1] == '-') argument++;
+    return !strcmp(argument + 1, name);
+}
+END
+
+cd ../server/
+if ! g++ -Wall -O2 -I"$SCRATCH/boinc" sss_work_generator.cpp -o "$SCRATCH/sss_work_generator"; then
+    echo "FAILED to build sss_work_generator against the stand-ins"
+    rm -rf "$SCRATCH"
+    exit 1
+fi
+cd ../bin/
+
+export STUB_PROJECT="$SCRATCH/project"
+ARGUMENTS="--max_set_value $M --subset_size $N --target_seconds 0.001 --throughput_file $SCRATCH/none --min_cushion 10"
+SLICES=$("$SCRATCH/sss_work_generator" $ARGUMENTS --dry_run 2>/dev/null | sed -n 's/^\([0-9]*\) slices of .*/\1/p')
+TOTAL=$("$SCRATCH/sss_work_generator" $ARGUMENTS --dry_run 2>/dev/null | sed -n 's/^\([0-9]*\) subsets .*/\1/p')
+
+STATUS=0
+fail() {
+    echo "FAILED: $1"
+    STATUS=1
+}
+
+# Enough polls to make every slice (at least 5 a poll) and carry on polling after that.
+STUB_POLLS=$((SLICES / 5 + 20)) "$SCRATCH/sss_work_generator" $ARGUMENTS 2> "$SCRATCH/first.log"
+
+[ "$(wc -l < "$STUB_PROJECT/workunits")" = "$SLICES" ] || fail "$(wc -l < "$STUB_PROJECT/workunits") workunits were made, not $SLICES"
+[ "$(sort -u "$STUB_PROJECT/workunits" | wc -l)" = "$SLICES" ] || fail "a workunit was made twice"
+[ "$(ls "$STUB_PROJECT/download" | wc -l)" = "$SLICES" ] || fail "$(ls "$STUB_PROJECT/download" | wc -l) input files were written, not $SLICES"
+[ "$(grep -c "Every slice has been made" "$SCRATCH/first.log")" = 1 ] || fail "'Every slice has been made' was logged $(grep -c "Every slice has been made" "$SCRATCH/first.log") times"
+
+# The input files are "<M> <N> <i> <count>", and should follow on from each other from 0 to the total.
+COVERED=$(cat "$STUB_PROJECT"/download/* | sort -n -k3 | awk -v M="$M" -v N="$N" '
+    $1 != M || $2 != N || $3 != next_rank { print "gap at " $3; exit }
+    { next_rank = $3 + $4 }
+    END { print next_rank }')
+[ "$COVERED" = "$TOTAL" ] || fail "the slices cover up to $COVERED, not the $TOTAL subsets"
+
+STUB_POLLS=5 "$SCRATCH/sss_work_generator" $ARGUMENTS 2> "$SCRATCH/second.log"
+grep -q "Carrying on from subset $TOTAL" "$SCRATCH/second.log" || fail "the restart didn't carry on from the state file"
+[ "$(wc -l < "$STUB_PROJECT/workunits")" = "$SLICES" ] || fail "the restart made more workunits"
+[ "$(grep -c "Every slice has been made" "$SCRATCH/second.log")" = 1 ] || fail "'Every slice has been made' wasn't logged once after the restart"
+
+[ -e "$STUB_PROJECT/rollbacks" ] && fail "a batch was rolled back when nothing failed"
+
+# The second insert fails, which should roll its batch back (and stop the generator), leaving only the first batch.
+rm -rf "$STUB_PROJECT/workunits" "$STUB_PROJECT/download" "$STUB_PROJECT/sss_work_generator_state.txt"
+mkdir "$STUB_PROJECT/download"
+STUB_FAIL_INSERT=2 STUB_POLLS=$((SLICES / 5 + 20)) "$SCRATCH/sss_work_generator" $ARGUMENTS 2> "$SCRATCH/failed.log"
+FIRST_BATCH=$(wc -l < "$STUB_PROJECT/workunits")
+[ "$(cat "$STUB_PROJECT/rollbacks" 2> /dev/null | wc -l)" = 1 ] || fail "the failed batch wasn't rolled back once"
+[ -e "$STUB_PROJECT/open_transactions" ] && fail "the generator exited with a transaction open"
+[ "$FIRST_BATCH" -lt "$SLICES" ] || fail "the failed batch was made anyway"
+
+STUB_POLLS=$((SLICES / 5 + 20)) "$SCRATCH/sss_work_generator" $ARGUMENTS 2> "$SCRATCH/after_failure.log"
+[ "$(wc -l < "$STUB_PROJECT/workunits")" = "$SLICES" ] || fail "$(wc -l < "$STUB_PROJECT/workunits") workunits were made after the failed batch, not $SLICES"
+[ "$(sort -u "$STUB_PROJECT/workunits" | wc -l)" = "$SLICES" ] || fail "a workunit was made twice after the failed batch"
+
+rm -rf "$SCRATCH"
+[ $STATUS = 0 ] && echo "sss_work_generator made the $SLICES slices of $M $N once each (rolling back a failed batch), and logged the end once."
+exit $STATUS
@@ -0,0 +1,53 @@
+#!/bin/bash
+# Kills the client over and over while it runs a problem with -DENABLE_CHECKPOINTING, restarting it from its checkpoint
+# each time, and checks the output it ends up with is the same as an uninterrupted run's (the failed sets once each,
+# in order, and the same totals), eg:
+#   ./test_checkpoint_resume.sh 40 6 -DENABLE_THREADS
+# The first arguments are the M and N (40 and 6 by default), and the rest are passed on to g++.
+M=${1:-40}
+N=${2:-6}
+shift 2
+SCRATCH=$(mktemp -d) || exit 1
+
+cd ../client/
+if ! g++ -Wall -O2 -DENABLE_CHECKPOINTING -DVERBOSE -DFALSE_ONLY "$@" subset_sum_main.cpp -o "$SCRATCH/subset_sum" -pthread; then
+    rm -rf "$SCRATCH"
+    exit 1
+fi
+
+# The client keeps its checkpoint in the directory it is run from.
+cd "$SCRATCH"
+./subset_sum "$M" "$N" > expected.txt 2> /dev/null
+rm -f sss_checkpoint.txt
+
+# Each run is killed 0.1 to 0.3 seconds in (20 times, unless it finishes first), checkpointing every 0.02 seconds.
+# The output is opened without truncating it (1<>), as the client cuts it back to its last checkpoint itself.
+KILLS=0
+while [ $KILLS -lt 20 ]; do
+    ./subset_sum --checkpoint-interval 0.02 --progress-interval 0.02 "$M" "$N" 1<> output.txt 2>> errors.txt &
+    CLIENT=$!
+    sleep 0.$((RANDOM % 3 + 1))
+    kill -KILL $CLIENT 2> /dev/null || break
+    wait $CLIENT 2> /dev/null
+    KILLS=$((KILLS + 1))
+done
+wait
+./subset_sum "$M" "$N" 1<> output.txt 2>> errors.txt
+
+STATUS=0
+RESUMES=$(grep -c "Starting from checkpoint" errors.txt)
+if grep -q "does not match the checkpoint" errors.txt; then
+    echo "FAILED: the output didn't match a checkpoint, so it started over"
+    STATUS=1
+elif [ "$KILLS" = 0 ] || [ "$RESUMES" = 0 ]; then
+    echo "FAILED: the run was never killed after a checkpoint ($KILLS kills, $RESUMES resumes), try a bigger M and N"
+    STATUS=1
+elif ! diff <(grep -Ev "seconds|Starting" expected.txt) <(grep -Ev "seconds|Starting" output.txt) > /dev/null; then
+    echo "FAILED: the output after $KILLS kills is not the same as an uninterrupted run's"
+    STATUS=1
+fi
+
+cd - > /dev/null
+rm -rf "$SCRATCH"
+[ $STATUS = 0 ] && echo "$M $N was killed $KILLS times (resuming from $RESUMES checkpoints), and the output matches an uninterrupted run."
+exit $STATUS
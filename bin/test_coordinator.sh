@@ -0,0 +1,78 @@
+#!/bin/bash
+# Runs a problem through sss_coordinator in ways which split and hand out slices again, and checks each one finishes
+# (within a minute) with the same totals and failed sets as one run of the client:
+#   - the slices are much smaller than the workers can manage (--target_seconds 0.01 without a throughput file, so
+#     they are all late going by the plan's guess), without checkpoints and with them,
+#   - with workers killed every so often as well,
+#   - with the coordinator killed part way and carried on from its journal.
+# eg:
+#   ./test_coordinator.sh 40 6
+# The arguments are the M and N (40 and 6 by default).
+M=${1:-40}
+N=${2:-6}
+SCRATCH=$(mktemp -d) || exit 1
+
+cd ../client/
+g++ -Wall -O2 -DENABLE_CHECKPOINTING -DVERBOSE -DFALSE_ONLY subset_sum_main.cpp -o "$SCRATCH/subset_sum" -pthread || exit 1
+cd ../server/
+g++ -Wall -O2 sss_coordinator.cpp -o "$SCRATCH/sss_coordinator" || exit 1
+cd "$SCRATCH"
+
+./subset_sum "$M" "$N" 2> /dev/null > client.txt
+grep "\] = " client.txt > expected.txt
+EXPECTED_TOTALS=$(grep "total sets" client.txt | sed 's/, [0-9.]* success rate\.//')
+
+COORDINATOR="./sss_coordinator --client ./subset_sum --workers 5 --target_seconds 0.01 --throughput_file none"
+STATUS=0
+
+# Checks the totals (printed by the coordinator to totals.txt) and the failed sets (in output.txt) of a run.
+check() {
+    local TOTALS=$(grep "total sets" totals.txt | sed 's/, [0-9.]* success rate\.//')
+    if [ "$TOTALS" != "$EXPECTED_TOTALS" ]; then
+        echo "FAILED ($1): got '$TOTALS', the client got '$EXPECTED_TOTALS'"
+        STATUS=1
+    elif ! cmp -s output.txt expected.txt; then
+        echo "FAILED ($1): the failed sets are not the same as the client's"
+        STATUS=1
+    else
+        echo "$1: $(grep -o "[0-9]* workers died, [0-9]* late slices split" totals.txt)"
+    fi
+}
+
+run() {
+    local NAME=$1
+    shift
+    rm -f output.txt journal.txt
+    if ! timeout 60 $COORDINATOR --output output.txt --journal journal.txt "$@" "$M" "$N" > totals.txt 2> errors.txt; then
+        echo "FAILED ($NAME): the coordinator didn't finish within a minute ($(grep -c splitting errors.txt) splits)"
+        STATUS=1
+        return
+    fi
+    check "$NAME"
+}
+
+run "without checkpoints"
+run "with checkpoints" --checkpoint_interval 0.05
+run "with checkpoints and kills" --checkpoint_interval 0.05 --kill_interval 0.2
+
+# The coordinator is killed 0.5 seconds in (its workers stop when their stdin closes), and started again.
+rm -f output.txt journal.txt
+$COORDINATOR --output output.txt --journal journal.txt --checkpoint_interval 0.05 "$M" "$N" > /dev/null 2>&1 &
+KILLED=$!
+sleep 0.5
+kill -KILL $KILLED 2> /dev/null
+wait $KILLED 2> /dev/null
+if ! timeout 60 $COORDINATOR --output output.txt --journal journal.txt --checkpoint_interval 0.05 "$M" "$N" > totals.txt 2> errors.txt; then
+    echo "FAILED (carried on from the journal): the coordinator didn't finish within a minute ($(grep -c splitting errors.txt) splits)"
+    STATUS=1
+elif ! grep -q "carrying on from subset" errors.txt; then
+    echo "FAILED (carried on from the journal): it started over, try a bigger M and N"
+    STATUS=1
+else
+    check "carried on from the journal"
+fi
+
+cd - > /dev/null
+rm -rf "$SCRATCH"
+[ $STATUS = 0 ] && echo "sss_coordinator got the same totals and failed sets as the client for $M $N every time."
+exit $STATUS
@@ -0,0 +1,259 @@
+#ifndef SUBSET_SUM_FAILED_SET_RECORDS_HPP
+#define SUBSET_SUM_FAILED_SET_RECORDS_HPP
+
+#include <cstdio>
+#include <vector>
+
+#include "subset_ranks.hpp"
+#include "subset_output.hpp"
+
+/**
+ *  With -DBINARY_OUTPUT the client writes the failed sets as binary records instead of a text report, and
+ *  render_failed_sets turns the records back into the text, color or HTML report.  A record only holds the rank of the
+ *  failed set (the subset is rebuilt from it with the enumerator for the order, and its sums are recalculated), and the
+ *  ranges of sums it is missing.
+ *
+ *  The file starts with a header of FAILED_SET_HEADER_SIZE bytes, with every number little endian:
+ *
+ *      "SSSF"          4 bytes
+ *      version         1 byte, FAILED_SET_VERSION
+ *      flags           1 byte, any of FAILED_SET_SLICE, FAILED_SET_MISSING_SUMS and FAILED_SET_FULL_RANGE
+ *      order           1 byte, the subset_order of the ranks
+ *      (unused)        1 byte
+ *      M, N            4 bytes each
+ *      first_rank      16 bytes, the rank of the first subset tested
+ *      count           16 bytes, the <count> of a slice (0 unless FAILED_SET_SLICE)
+ *
+ *  followed by the records, where every number is an unsigned LEB128 varint (7 bits a byte, lowest first):
+ *
+ *      'F' rank - first_rank [ranges { start - next, length - 1 } ...]
+ *      'E' pass fail
+ *
+ *  There is an 'F' record for each failed set, and an 'E' record at the end of a finished run.  With
+ *  FAILED_SET_MISSING_SUMS each 'F' record also has the number of ranges of sums between M and the largest sum tested
+ *  (S / 2, or S - M with FAILED_SET_FULL_RANGE) which can't be made, then the ranges, where next is M for the first
+ *  range and one past the end of the range before it after that.
+ */
+const unsigned int FAILED_SET_HEADER_SIZE = 48;
+const unsigned char FAILED_SET_VERSION = 1;
+
+const unsigned char FAILED_SET_SLICE = 1;
+const unsigned char FAILED_SET_MISSING_SUMS = 2;
+const unsigned char FAILED_SET_FULL_RANGE = 4;
+
+const unsigned char FAILED_SET_RECORD = 'F';
+const unsigned char FAILED_SET_END = 'E';
+
+/**
+ *  Enough bytes for a subset_rank_t as a varint.
+ */
+const unsigned int MAX_VARINT_LENGTH = (sizeof(subset_rank_t) * 8 + 6) / 7;
+
+struct failed_set_header {
+    unsigned char flags;
+    unsigned char order;
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    subset_rank_t first_rank;
+    subset_rank_t count;
+};
+
+/**
+ *  The sums first ... last (inclusive) can't be made.
+ */
+struct missing_sums {
+    unsigned int first;
+    unsigned int last;
+};
+
+struct failed_set_record {
+    unsigned char type;
+    subset_rank_t rank_offset;
+    std::vector<missing_sums> missing;
+    unsigned long long pass;
+    unsigned long long fail;
+};
+
+static inline void put_little_endian(unsigned char *bytes, subset_rank_t value, const unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        bytes[i] = (unsigned char)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+/**
+ *  Reads count bytes, returning false if the value doesn't fit in a subset_rank_t.
+ */
+static inline bool get_little_endian(const unsigned char *bytes, subset_rank_t &value, const unsigned int count) {
+    value = 0;
+    for (unsigned int i = count; i > 0; i--) {
+        if (i > sizeof(subset_rank_t)) {
+            if (bytes[i - 1] != 0) return false;
+            continue;
+        }
+        value = (value << 8) | bytes[i - 1];
+    }
+    return true;
+}
+
+inline void write_failed_set_header(FILE *output, const failed_set_header &header) {
+    unsigned char bytes[FAILED_SET_HEADER_SIZE];
+
+    memcpy(bytes, "SSSF", 4);
+    bytes[4] = FAILED_SET_VERSION;
+    bytes[5] = header.flags;
+    bytes[6] = header.order;
+    bytes[7] = 0;
+    put_little_endian(bytes + 8, header.max_set_value, 4);
+    put_little_endian(bytes + 12, header.subset_size, 4);
+    put_little_endian(bytes + 16, header.first_rank, 16);
+    put_little_endian(bytes + 32, header.count, 16);
+
+    fwrite(bytes, 1, FAILED_SET_HEADER_SIZE, output);
+}
+
+/**
+ *  Returns false if input doesn't start with a header (of this version), or its ranks don't fit in a subset_rank_t.
+ */
+inline bool read_failed_set_header(FILE *input, failed_set_header &header) {
+    unsigned char bytes[FAILED_SET_HEADER_SIZE];
+    subset_rank_t value;
+
+    if (fread(bytes, 1, FAILED_SET_HEADER_SIZE, input) != FAILED_SET_HEADER_SIZE) return false;
+    if (memcmp(bytes, "SSSF", 4) != 0 || bytes[4] != FAILED_SET_VERSION) return false;
+
+    header.flags = bytes[5];
+    header.order = bytes[6];
+    get_little_endian(bytes + 8, value, 4);
+    header.max_set_value = (unsigned int)value;
+    get_little_endian(bytes + 12, value, 4);
+    header.subset_size = (unsigned int)value;
+
+    return get_little_endian(bytes + 16, header.first_rank, 16) && get_little_endian(bytes + 32, header.count, 16);
+}
+
+/**
+ *  Writes value as a varint to bytes, returning how many bytes it took (at most MAX_VARINT_LENGTH).
+ */
+static inline unsigned int encode_varint(subset_rank_t value, unsigned char *bytes) {
+    unsigned int length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = (unsigned char)(value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    bytes[length++] = (unsigned char)value;
+    return length;
+}
+
+/**
+ *  Returns false at the end of input, or if the varint is too long for a subset_rank_t.
+ */
+static inline bool read_varint(FILE *input, subset_rank_t &value) {
+    value = 0;
+    for (unsigned int shift = 0; shift < MAX_VARINT_LENGTH * 7; shift += 7) {
+        int byte = fgetc(input);
+        if (byte == EOF) return false;
+
+        value |= ((subset_rank_t)(byte & 0x7F)) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static inline void append_varint(result_buffer &results, const subset_rank_t value) {
+    unsigned char bytes[MAX_VARINT_LENGTH];
+    append_results(results, (const char*)bytes, encode_varint(value, bytes));
+}
+
+/**
+ *  Sets missing to the ranges of sums from min to max that can't be made from a subset (adding up to subset_sum) with
+ *  the sums in bit_array.
+ */
+template <typename word_t>
+void find_missing_sums(const word_t *bit_array, const unsigned int length, const unsigned int subset_sum, const unsigned int min, const unsigned int max, std::vector<missing_sums> &missing) {
+    missing.clear();
+
+    for (unsigned int sum = min; sum <= max; sum++) {
+        if (has_sum(bit_array, length, subset_sum, sum)) continue;
+
+        if (!missing.empty() && missing.back().last == sum - 1) {
+            missing.back().last = sum;
+        } else {
+            missing_sums range = { sum, sum };
+            missing.push_back(range);
+        }
+    }
+}
+
+/**
+ *  Adds an 'F' record to results, with the missing sums (of a subset with largest element M) unless missing is NULL.
+ */
+inline void append_failed_set(result_buffer &results, const subset_rank_t rank_offset, const unsigned int M, const std::vector<missing_sums> *missing) {
+    append_char(results, FAILED_SET_RECORD);
+    append_varint(results, rank_offset);
+
+    if (missing != NULL) {
+        append_varint(results, missing->size());
+
+        unsigned int next = M;
+        for (unsigned int i = 0; i < missing->size(); i++) {
+            append_varint(results, (*missing)[i].first - next);
+            append_varint(results, (*missing)[i].last - (*missing)[i].first);
+            next = (*missing)[i].last + 1;
+        }
+    }
+}
+
+inline void write_failed_set_end(FILE *output, const unsigned long long pass, const unsigned long long fail) {
+    unsigned char bytes[1 + (2 * MAX_VARINT_LENGTH)];
+    unsigned int length = 0;
+
+    bytes[length++] = FAILED_SET_END;
+    length += encode_varint(pass, bytes + length);
+    length += encode_varint(fail, bytes + length);
+
+    fwrite(bytes, 1, length, output);
+}
+
+/**
+ *  Reads the next record (of a file with header), returning false at the end of input or if the record is cut off or
+ *  not one of the record types.
+ */
+inline bool read_failed_set_record(FILE *input, const failed_set_header &header, failed_set_record &record) {
+    int type = fgetc(input);
+    if (type == EOF) return false;
+
+    record.type = (unsigned char)type;
+    record.missing.clear();
+
+    subset_rank_t value;
+    if (record.type == FAILED_SET_END) {
+        if (!read_varint(input, value)) return false;
+        record.pass = (unsigned long long)value;
+        if (!read_varint(input, value)) return false;
+        record.fail = (unsigned long long)value;
+        return true;
+    }
+
+    if (record.type != FAILED_SET_RECORD) return false;
+    if (!read_varint(input, record.rank_offset)) return false;
+
+    if (header.flags & FAILED_SET_MISSING_SUMS) {
+        subset_rank_t ranges, gap, length;
+        if (!read_varint(input, ranges)) return false;
+
+        unsigned int next = header.max_set_value;
+        for (subset_rank_t i = 0; i < ranges; i++) {
+            if (!read_varint(input, gap) || !read_varint(input, length)) return false;
+
+            missing_sums range;
+            range.first = next + (unsigned int)gap;
+            range.last = range.first + (unsigned int)length;
+            record.missing.push_back(range);
+            next = range.last + 1;
+        }
+    }
+    return true;
+}
+
+#endif
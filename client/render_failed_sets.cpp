@@ -0,0 +1,171 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include <vector>
+
+#include "shift_or.hpp"
+#include "subset_ranks.hpp"
+#include "subset_output.hpp"
+#include "failed_set_records.hpp"
+
+using namespace std;
+
+/**
+ *  Renders the binary failed set records written by the client (compiled with -DBINARY_OUTPUT) as the text report the
+ *  client would have printed with -DVERBOSE -DFALSE_ONLY.  It takes the same -DENABLE_COLOR, -DHTML_OUTPUT and
+ *  -DFULL_RANGE_SUMS flags as the client to pick the kind of report, eg:
+ *
+ *      g++ -Wall -O3 -DENABLE_COLOR render_failed_sets.cpp -o render_failed_sets
+ *      ./render_failed_sets failed_sets.bin > failed_sets.txt
+ *
+ *  Each failed set is rebuilt from its rank with the enumerator for the order in the header, and its sums are
+ *  recalculated (over the full range).  It quits with an error if a set passes, or its missing sums aren't the ones in
+ *  its record, so this also checks the records.
+ */
+
+/**
+ *  Sets sums to every sum that can be made from subset (with the most significant element first, as in the client).
+ */
+static void calculate_all_sums(uint64_t *sums, const unsigned int length, const unsigned int *subset, const unsigned int subset_size) {
+    memset(sums, 0, length * sizeof(uint64_t));
+
+    for (unsigned int i = 0; i < subset_size; i++) {
+        unsigned int bit = subset[i] - 1;
+
+        shift_or(sums, length, sums, subset[i]);
+        sums[length - (bit / 64) - 1] |= ((uint64_t)1) << (bit % 64);
+    }
+}
+
+static bool same_missing_sums(const vector<missing_sums> &a, const vector<missing_sums> &b) {
+    if (a.size() != b.size()) return false;
+
+    for (unsigned int i = 0; i < a.size(); i++) {
+        if (a[i].first != b[i].first || a[i].last != b[i].last) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2) {
+        fprintf(stderr, "USAGE:\n");
+        fprintf(stderr, "\t./render_failed_sets [<records>]\n\n");
+        fprintf(stderr, "\t<records>  :   (optional) the failed set records written by the client, otherwise they are read from stdin.\n");
+        exit(0);
+    }
+
+    FILE *input = stdin;
+    if (argc == 2) {
+        input = fopen(argv[1], "rb");
+        if (input == NULL) {
+            fprintf(stderr, "ERROR: could not open '%s'.\n", argv[1]);
+            exit(0);
+        }
+    }
+
+    failed_set_header header;
+    if (!read_failed_set_header(input, header)) {
+        fprintf(stderr, "ERROR: the input does not start with a failed set header (or its ranks are too big for this build).\n");
+        exit(0);
+    }
+
+    const unsigned int M = header.max_set_value;
+    const unsigned int N = header.subset_size;
+
+    if (N == 0 || M < N || header.order >= SUBSET_ORDERS) {
+        fprintf(stderr, "ERROR: the failed set header has M = %u, N = %u and order %u, which can't be right.\n", M, N, header.order);
+        exit(0);
+    }
+
+    init_bit_characters();
+    init_binomials(M - 1, N - 1);
+
+    subset_rank_t expected_total = n_choose_k(M - 1, N - 1);
+    bool doing_slice = (header.flags & FAILED_SET_SLICE) != 0;
+
+    char expected_total_string[RANK_STRING_LENGTH];
+    char subsets_to_calculate_string[RANK_STRING_LENGTH];
+    rank_to_string(expected_total, expected_total_string);
+    rank_to_string(header.count, subsets_to_calculate_string);
+
+    init_report_widths(M, expected_total);
+    print_report_start(stdout, M, N, false);
+    print_report_evaluations(stdout, doing_slice ? subsets_to_calculate_string : expected_total_string);
+
+    /**
+     *  The same number of bits as the client prints.
+     */
+    unsigned long max_set_sum = 0;
+    for (unsigned int i = 0; i < N; i++) max_set_sum += M - i;
+
+    unsigned int sums_bits = ((max_set_sum / PRINT_ELEMENT_SIZE) + 1) * PRINT_ELEMENT_SIZE;
+    unsigned int sums_length = (max_set_sum / 64) + 1;
+
+    uint64_t *sums = new uint64_t[sums_length];
+    char *sums_line = new char[sums_bits];
+    vector<missing_sums> missing;
+
+    result_buffer results;
+    new_result_buffer(results, stdout);
+
+    subset_enumerator *enumerator = new_subset_enumerator((subset_order)header.order, M, N);
+    failed_set_record record;
+    bool finished = false;
+
+    while (read_failed_set_record(input, header, record)) {
+        if (record.type == FAILED_SET_END) {
+            flush_results(results);
+            print_report_totals(stdout, doing_slice, subsets_to_calculate_string, expected_total_string, record.pass, record.fail);
+            finished = true;
+            break;
+        }
+
+        char rank_string[RANK_STRING_LENGTH];
+        subset_rank_t rank = header.first_rank + record.rank_offset;
+
+        enumerator->seek(rank);
+        if (enumerator->done()) {
+            fprintf(stderr, "ERROR: failed set %s is past the last subset.\n", rank_to_string(rank, rank_string));
+            exit(1);
+        }
+
+        const unsigned int *subset = enumerator->subset;
+        unsigned int subset_sum = 0;
+        for (unsigned int i = 0; i < N; i++) subset_sum += subset[i];
+
+        calculate_all_sums(sums, sums_length, subset, N);
+
+        unsigned int max = (header.flags & FAILED_SET_FULL_RANGE) ? subset_sum - M : subset_sum / 2;
+        find_missing_sums(sums, sums_length, subset_sum, M, max, missing);
+
+        if (missing.empty()) {
+            fprintf(stderr, "ERROR: failed set %s passes.\n", rank_to_string(rank, rank_string));
+            exit(1);
+        }
+
+        if ((header.flags & FAILED_SET_MISSING_SUMS) && !same_missing_sums(missing, record.missing)) {
+            fprintf(stderr, "ERROR: the missing sums of failed set %s do not match its record.\n", rank_to_string(rank, rank_string));
+            exit(1);
+        }
+
+        print_tested_subset(results, sums_line, rank, subset, N, sums, sums_length, subset_sum, sums_bits, false);
+    }
+    flush_results(results);
+
+    if (!finished) {
+        fprintf(stderr, "ERROR: the records end without the pass and fail counts, the run may not have finished.\n");
+        exit(1);
+    }
+
+    print_report_end(stdout);
+
+    delete enumerator;
+    delete_result_buffer(results);
+    delete [] sums;
+    delete [] sums_line;
+
+    if (input != stdin) fclose(input);
+    return 0;
+}
@@ -0,0 +1,226 @@
+#ifndef SUBSET_SUM_RUN_STATS_HPP
+#define SUBSET_SUM_RUN_STATS_HPP
+
+/**
+ *  With -DRUN_STATS the client counts where its time goes, and writes the counts to a JSON file at the end of the run
+ *  (see print_run_stats in subset_sum_main.cpp).  Without it, COUNT_STAT compiles to nothing.
+ *
+ *  The counters are kept per thread (in shared_stats::thread_stats) so the hot loops don't share any cache lines, and
+ *  are added to shared_stats::run_stats by add_thread_stats when a thread's tester is deleted.  The split of time
+ *  between enumerating and testing subsets comes from timing a random sample of about one in STATS_SAMPLE_INTERVAL subsets (the overhead of
+ *  reading the clock is taken off each timing), as timing every subset would take longer than testing it.  The time
+ *  spent writing output and checkpoints is timed exactly.
+ *
+ *  Hardware counters (cycles, instructions and cache misses) are read with perf_event_open on Linux, for the whole
+ *  process including any threads it starts.  They are left out if the kernel doesn't allow it (see
+ *  /proc/sys/kernel/perf_event_paranoid) or there is no PMU (eg in some virtual machines).
+ */
+#ifdef RUN_STATS
+
+#include <cstring>
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HARDWARE_COUNTERS
+#endif
+
+struct run_counters {
+    unsigned long long sums_tests;          // subsets whose sums were tested (not accepted by a filter), by test_subset,
+                                            // a last element sweep or the revolving door sum counts
+    unsigned long long sweeps;              // last element sweeps started
+    unsigned long long dp_words;            // bitset words (or sum counts, in revolving door order) calculated or scanned
+    unsigned long long early_exits;         // all_ones tests that stopped before the last word of their range
+    unsigned long long timed_subsets;
+    double enumeration_seconds;             // of the timed subsets
+    double testing_seconds;                 // of the timed subsets
+    unsigned long long output_writes;
+    double output_seconds;
+    unsigned long long checkpoints;
+    double checkpoint_seconds;
+
+    unsigned int sample_countdown;
+    unsigned int sample_seed;
+};
+
+const unsigned int STATS_SAMPLE_INTERVAL = 256;
+
+struct hardware_counter {
+    const char *name;
+    uint64_t config;
+};
+
+#ifdef HARDWARE_COUNTERS
+static const hardware_counter hardware_counters[] = {
+    { "cycles", PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache_references", PERF_COUNT_HW_CACHE_REFERENCES },
+    { "cache_misses", PERF_COUNT_HW_CACHE_MISSES },
+};
+const unsigned int HARDWARE_COUNTERS_COUNT = sizeof(hardware_counters) / sizeof(hardware_counter);
+#else
+static const hardware_counter * const hardware_counters = NULL;
+const unsigned int HARDWARE_COUNTERS_COUNT = 0;
+#endif
+
+/**
+ *  The counters (and the hardware counters' file descriptors) shared by every file including this header (see
+ *  binomial_table in subset_ranks.hpp).
+ */
+template <typename unused_t>
+struct run_stats_storage {
+    static __thread run_counters thread_stats;
+    static run_counters run_stats;
+    static double clock_overhead;
+    static int hardware_counter_fds[HARDWARE_COUNTERS_COUNT + 1];
+};
+
+template <typename unused_t> __thread run_counters run_stats_storage<unused_t>::thread_stats;
+template <typename unused_t> run_counters run_stats_storage<unused_t>::run_stats;
+template <typename unused_t> double run_stats_storage<unused_t>::clock_overhead = 0;
+template <typename unused_t> int run_stats_storage<unused_t>::hardware_counter_fds[HARDWARE_COUNTERS_COUNT + 1];
+
+typedef run_stats_storage<void> shared_stats;
+
+#define COUNT_STAT(counter, n) (shared_stats::thread_stats.counter += (n))
+
+static inline double stats_time() {
+#if defined(CLOCK_MONOTONIC) && !defined(_WIN32)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+#else
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + (now.tv_usec / 1e6);
+#endif
+}
+
+/**
+ *  Measures the average time between two reads of the clock, which is taken off the time of each sample.
+ */
+inline void init_stats_clock() {
+    const unsigned int reads = 10000;
+
+    double start = stats_time();
+    for (unsigned int i = 1; i < reads; i++) stats_time();
+    shared_stats::clock_overhead = (stats_time() - start) / reads;
+}
+
+/**
+ *  Adds the calling thread's counters to run_stats and clears them (the sampling state is kept).  Threads must hold
+ *  chunk_mutex.
+ */
+inline void add_thread_stats() {
+    run_counters &run = shared_stats::run_stats;
+    run_counters &thread = shared_stats::thread_stats;
+
+    run.sums_tests += thread.sums_tests;
+    run.sweeps += thread.sweeps;
+    run.dp_words += thread.dp_words;
+    run.early_exits += thread.early_exits;
+    run.timed_subsets += thread.timed_subsets;
+    run.enumeration_seconds += thread.enumeration_seconds;
+    run.testing_seconds += thread.testing_seconds;
+    run.output_writes += thread.output_writes;
+    run.output_seconds += thread.output_seconds;
+    run.checkpoints += thread.checkpoints;
+    run.checkpoint_seconds += thread.checkpoint_seconds;
+
+    unsigned int countdown = thread.sample_countdown;
+    unsigned int seed = thread.sample_seed;
+    memset(&thread, 0, sizeof(run_counters));
+    thread.sample_countdown = countdown;
+    thread.sample_seed = seed;
+}
+
+/**
+ *  Times parts of testing one subset, if it is one of the sampled ones:
+ *
+ *      stats_sample sample;
+ *      start_stats_sample(sample);
+ *      ... test the subset ...
+ *      lap_stats_sample(sample, shared_stats::thread_stats.testing_seconds);
+ *      ... move to the next subset ...
+ *      lap_stats_sample(sample, shared_stats::thread_stats.enumeration_seconds);
+ *      end_stats_sample(sample);
+ *
+ *  The gaps between sampled subsets are random (1 to 2 * STATS_SAMPLE_INTERVAL - 1), so they don't line up with the
+ *  sweeps or any other pattern in the subsets.
+ */
+struct stats_sample {
+    bool timed;
+    double last;
+};
+
+static inline void start_stats_sample(stats_sample &sample) {
+    sample.timed = false;
+    sample.last = 0;
+    run_counters &thread = shared_stats::thread_stats;
+    if (thread.sample_countdown-- > 1) return;
+
+    thread.sample_seed = (thread.sample_seed * 1103515245) + 12345;
+    thread.sample_countdown = 1 + ((thread.sample_seed >> 16) % ((2 * STATS_SAMPLE_INTERVAL) - 1));
+
+    sample.timed = true;
+    sample.last = stats_time();
+}
+
+static inline void lap_stats_sample(stats_sample &sample, double &seconds) {
+    if (!sample.timed) return;
+
+    double now = stats_time();
+    if (now - sample.last > shared_stats::clock_overhead) seconds += (now - sample.last) - shared_stats::clock_overhead;
+    sample.last = now;
+}
+
+static inline void end_stats_sample(const stats_sample &sample) {
+    if (sample.timed) shared_stats::thread_stats.timed_subsets++;
+}
+
+/**
+ *  Starts the hardware counters, which count user space events of this process and the threads it starts after this.
+ */
+inline void start_hardware_counters() {
+#ifdef HARDWARE_COUNTERS
+    for (unsigned int i = 0; i < HARDWARE_COUNTERS_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = hardware_counters[i].config;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        shared_stats::hardware_counter_fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+/**
+ *  Returns false if the counter couldn't be started or read.  Counts from threads are only included once they have
+ *  finished.
+ */
+inline bool read_hardware_counter(const unsigned int counter, unsigned long long &value) {
+#ifdef HARDWARE_COUNTERS
+    uint64_t count;
+    if (shared_stats::hardware_counter_fds[counter] < 0) return false;
+    if (read(shared_stats::hardware_counter_fds[counter], &count, sizeof(count)) != sizeof(count)) return false;
+
+    value = count;
+    return true;
+#else
+    return false;
+#endif
+}
+
+#else
+#define COUNT_STAT(counter, n)
+#endif
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef SUBSET_SUM_SHIFT_OR_HPP
+#define SUBSET_SUM_SHIFT_OR_HPP
+
+#include <cstring>
+
+/**
+ *  The fused shift-or kernel used to add a new element to a sums bitset:
+ *
+ *      dest = src | (src << shift)
+ *
+ *  Bitsets are stored with the most significant element first (ie the lowest sums are in src[length - 1]), so element i
+ *  of the result only depends on elements i, i + full_element_shifts and i + full_element_shifts + 1 of src.  This lets
+ *  the vector versions load each of them unaligned and do the whole thing in one pass, instead of the separate
+ *  shift_left and or_equal passes.
+ *
+ *  The kernels are templated on the element type of the bitset (word_t), which can be 32 or 64 bits.
+ *
+ *  There are SSE2, AVX2 and AVX-512 versions of the kernel, which is picked at startup (using cpuid) by
+ *  select_shift_or_kernel, so a single binary will use the widest vectors the host supports.  Compiling with
+ *  -DNO_SIMD_DISPATCH only uses the portable version.
+ */
+
+#if !defined(NO_SIMD_DISPATCH) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+/**
+ *  Finishes a shift-or from element i onwards (after a vector version has done the elements before i), and copies
+ *  over the elements which have nothing shifted into them.
+ */
+template <typename word_t>
+static inline void shift_or_tail(unsigned int i, word_t *dest, const unsigned int length, const word_t *src, const unsigned int full_element_shifts, const unsigned int sub_shift) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    unsigned int shifted_length = length - full_element_shifts;
+
+    if (sub_shift == 0) {
+        for (; i < shifted_length; i++) dest[i] = src[i] | src[i + full_element_shifts];
+    } else {
+        for (; i < shifted_length - 1; i++) {
+            dest[i] = src[i] | src[i + full_element_shifts] << sub_shift | src[i + full_element_shifts + 1] >> (element_size - sub_shift);
+        }
+        dest[shifted_length - 1] = src[shifted_length - 1] | src[length - 1] << sub_shift;
+    }
+
+    if (dest != src) memcpy(dest + shifted_length, src + shifted_length, full_element_shifts * sizeof(word_t));
+}
+
+template <typename word_t>
+static inline void shift_or_portable(word_t *dest, const unsigned int length, const word_t *src, const unsigned int shift) {
+    unsigned int full_element_shifts = shift / (sizeof(word_t) * 8);
+
+    if (full_element_shifts >= length) {
+        if (dest != src) memcpy(dest, src, length * sizeof(word_t));
+        return;
+    }
+
+    shift_or_tail(0, dest, length, src, full_element_shifts, shift % (sizeof(word_t) * 8));
+}
+
+#ifdef SIMD_DISPATCH
+/**
+ *  The vector versions rely on vector shifts by the element size or more giving 0, so a sub_shift of 0 needs no special
+ *  case.  Each of them finishes off what's left after its widest loop with the narrower ones, so short bitsets still get
+ *  vectorized.  The element size is a compile time constant, so only one of the 32 and 64 bit shifts is kept.
+ */
+template <typename word_t>
+__attribute__((target("sse2")))
+static inline void shift_or_sse2_from(unsigned int i, word_t *dest, const unsigned int length, const word_t *src, const unsigned int full_element_shifts, const unsigned int sub_shift) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const unsigned int words_per_vector = 16 / sizeof(word_t);
+    const __m128i left = _mm_cvtsi32_si128(sub_shift);
+    const __m128i right = _mm_cvtsi32_si128(element_size - sub_shift);
+    const unsigned int vector_end = length - full_element_shifts - 1;
+
+    for (; i + words_per_vector <= vector_end; i += words_per_vector) {
+        __m128i current = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i high = _mm_loadu_si128((const __m128i*)(src + i + full_element_shifts));
+        __m128i low = _mm_loadu_si128((const __m128i*)(src + i + full_element_shifts + 1));
+
+        __m128i shifted;
+        if (element_size == 64) shifted = _mm_or_si128(_mm_sll_epi64(high, left), _mm_srl_epi64(low, right));
+        else                    shifted = _mm_or_si128(_mm_sll_epi32(high, left), _mm_srl_epi32(low, right));
+
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(current, shifted));
+    }
+
+    shift_or_tail(i, dest, length, src, full_element_shifts, sub_shift);
+}
+
+template <typename word_t>
+__attribute__((target("avx2")))
+static inline void shift_or_avx2_from(unsigned int i, word_t *dest, const unsigned int length, const word_t *src, const unsigned int full_element_shifts, const unsigned int sub_shift) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const unsigned int words_per_vector = 32 / sizeof(word_t);
+    const __m128i left = _mm_cvtsi32_si128(sub_shift);
+    const __m128i right = _mm_cvtsi32_si128(element_size - sub_shift);
+    const unsigned int vector_end = length - full_element_shifts - 1;
+
+    for (; i + words_per_vector <= vector_end; i += words_per_vector) {
+        __m256i current = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i high = _mm256_loadu_si256((const __m256i*)(src + i + full_element_shifts));
+        __m256i low = _mm256_loadu_si256((const __m256i*)(src + i + full_element_shifts + 1));
+
+        __m256i shifted;
+        if (element_size == 64) shifted = _mm256_or_si256(_mm256_sll_epi64(high, left), _mm256_srl_epi64(low, right));
+        else                    shifted = _mm256_or_si256(_mm256_sll_epi32(high, left), _mm256_srl_epi32(low, right));
+
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_or_si256(current, shifted));
+    }
+
+    shift_or_sse2_from(i, dest, length, src, full_element_shifts, sub_shift);
+}
+
+/**
+ *  The AVX-512 loop uses the zero masked shifts, as the unmasked ones set off a spurious -Wmaybe-uninitialized in gcc.
+ */
+template <typename word_t>
+__attribute__((target("avx512f")))
+static inline void shift_or_avx512_from(unsigned int i, word_t *dest, const unsigned int length, const word_t *src, const unsigned int full_element_shifts, const unsigned int sub_shift) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const unsigned int words_per_vector = 64 / sizeof(word_t);
+    const __m512i left = (element_size == 64) ? _mm512_set1_epi64(sub_shift) : _mm512_set1_epi32(sub_shift);
+    const __m512i right = (element_size == 64) ? _mm512_set1_epi64(element_size - sub_shift) : _mm512_set1_epi32(element_size - sub_shift);
+    const unsigned int vector_end = length - full_element_shifts - 1;
+
+    for (; i + words_per_vector <= vector_end; i += words_per_vector) {
+        __m512i current = _mm512_loadu_si512((const void*)(src + i));
+        __m512i high = _mm512_loadu_si512((const void*)(src + i + full_element_shifts));
+        __m512i low = _mm512_loadu_si512((const void*)(src + i + full_element_shifts + 1));
+
+        __m512i shifted;
+        if (element_size == 64) shifted = _mm512_or_si512(_mm512_maskz_sllv_epi64(0xFF, high, left), _mm512_maskz_srlv_epi64(0xFF, low, right));
+        else                    shifted = _mm512_or_si512(_mm512_maskz_sllv_epi32(0xFFFF, high, left), _mm512_maskz_srlv_epi32(0xFFFF, low, right));
+
+        _mm512_storeu_si512((void*)(dest + i), _mm512_or_si512(current, shifted));
+    }
+
+    shift_or_avx2_from(i, dest, length, src, full_element_shifts, sub_shift);
+}
+
+template <typename word_t>
+__attribute__((target("sse2")))
+static void shift_or_sse2(word_t *dest, const unsigned int length, const word_t *src, const unsigned int shift) {
+    unsigned int full_element_shifts = shift / (sizeof(word_t) * 8);
+
+    if (full_element_shifts >= length) {
+        if (dest != src) memcpy(dest, src, length * sizeof(word_t));
+        return;
+    }
+
+    shift_or_sse2_from(0, dest, length, src, full_element_shifts, shift % (sizeof(word_t) * 8));
+}
+
+template <typename word_t>
+__attribute__((target("avx2")))
+static void shift_or_avx2(word_t *dest, const unsigned int length, const word_t *src, const unsigned int shift) {
+    unsigned int full_element_shifts = shift / (sizeof(word_t) * 8);
+
+    if (full_element_shifts >= length) {
+        if (dest != src) memcpy(dest, src, length * sizeof(word_t));
+        return;
+    }
+
+    shift_or_avx2_from(0, dest, length, src, full_element_shifts, shift % (sizeof(word_t) * 8));
+}
+
+template <typename word_t>
+__attribute__((target("avx512f")))
+static void shift_or_avx512(word_t *dest, const unsigned int length, const word_t *src, const unsigned int shift) {
+    unsigned int full_element_shifts = shift / (sizeof(word_t) * 8);
+
+    if (full_element_shifts >= length) {
+        if (dest != src) memcpy(dest, src, length * sizeof(word_t));
+        return;
+    }
+
+    shift_or_avx512_from(0, dest, length, src, full_element_shifts, shift % (sizeof(word_t) * 8));
+}
+#endif
+
+enum shift_or_kernel { SHIFT_OR_PORTABLE, SHIFT_OR_SSE2, SHIFT_OR_AVX2, SHIFT_OR_AVX512 };
+
+/**
+ *  The kernel picked for the process, shared by every file including this header (see binomial_table in
+ *  subset_ranks.hpp).
+ */
+template <typename unused_t>
+struct shift_or_dispatch_t {
+    static shift_or_kernel selected;
+    static const char *kernel_name;
+};
+
+template <typename unused_t> shift_or_kernel shift_or_dispatch_t<unused_t>::selected = SHIFT_OR_PORTABLE;
+template <typename unused_t> const char *shift_or_dispatch_t<unused_t>::kernel_name = "portable";
+
+typedef shift_or_dispatch_t<void> shift_or_dispatch;
+
+/**
+ *  Picks the widest shift-or kernel supported by this CPU (and operating system).
+ */
+static inline void select_shift_or_kernel() {
+#ifdef SIMD_DISPATCH
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        shift_or_dispatch::selected = SHIFT_OR_AVX512;
+        shift_or_dispatch::kernel_name = "avx512";
+    } else if (__builtin_cpu_supports("avx2")) {
+        shift_or_dispatch::selected = SHIFT_OR_AVX2;
+        shift_or_dispatch::kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        shift_or_dispatch::selected = SHIFT_OR_SSE2;
+        shift_or_dispatch::kernel_name = "sse2";
+    }
+#endif
+}
+
+/**
+ *  dest = src | (src << shift), using the kernel picked by select_shift_or_kernel
+ */
+template <typename word_t>
+static inline void shift_or(word_t *dest, const unsigned int length, const word_t *src, const unsigned int shift) {
+    switch (shift_or_dispatch::selected) {
+#ifdef SIMD_DISPATCH
+        case SHIFT_OR_AVX512:   shift_or_avx512(dest, length, src, shift); break;
+        case SHIFT_OR_AVX2:     shift_or_avx2(dest, length, src, shift); break;
+        case SHIFT_OR_SSE2:     shift_or_sse2(dest, length, src, shift); break;
+#endif
+        default:                shift_or_portable(dest, length, src, shift); break;
+    }
+}
+
+#endif
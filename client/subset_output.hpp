@@ -0,0 +1,490 @@
+#ifndef SUBSET_SUM_SUBSET_OUTPUT_HPP
+#define SUBSET_SUM_SUBSET_OUTPUT_HPP
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cmath>
+
+#include "subset_ranks.hpp"
+#include "run_stats.hpp"
+
+/**
+ *  Formatting the text reports (plain, with -DENABLE_COLOR and with -DHTML_OUTPUT): the subsets with their sums, and
+ *  the lines before and after them.  This is shared by the client (with -DVERBOSE) and render_failed_sets, so a report
+ *  rendered from binary records is the same as one printed by the client.
+ */
+
+/**
+ *  Sums are always printed as if they were in 32 bit elements, so the output is the same whatever the word size.
+ */
+const unsigned int PRINT_ELEMENT_SIZE = 32;
+
+#ifdef HTML_OUTPUT
+/**
+ *  The widths the ranks and elements are padded to in HTML reports (see init_report_widths), shared by every file
+ *  including this header (see binomial_table in subset_ranks.hpp).
+ */
+template <typename unused_t>
+struct report_widths_t {
+    static double max_digits;
+    static double max_set_digits;
+};
+
+template <typename unused_t> double report_widths_t<unused_t>::max_digits = 0;
+template <typename unused_t> double report_widths_t<unused_t>::max_set_digits = 0;
+
+typedef report_widths_t<void> report_widths;
+#endif
+
+/**
+ *  Returns bit number bit of a bit array (with the most significant element first), or 0 if it's past the end.
+ */
+template <typename word_t>
+static inline bool get_bit(const word_t *bit_array, const unsigned int length, const unsigned int bit) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    unsigned int pos = bit / element_size;
+
+    if (pos >= length) return false;
+    return (bit_array[length - pos - 1] >> (bit % element_size)) & 1;
+}
+
+/**
+ *  Returns true if sum can be made from a subset (adding up to subset_sum) with the sums in bit_array.  Sums over half
+ *  of subset_sum are looked up by symmetry, as they may have been cut off the bitset.
+ */
+template <typename word_t>
+static inline bool has_sum(const word_t *bit_array, const unsigned int length, const unsigned int subset_sum, unsigned int sum) {
+#ifdef FULL_RANGE_SUMS
+    return get_bit(bit_array, length, sum - 1);
+#else
+    if (sum > subset_sum) return false;
+    if (sum > subset_sum / 2) sum = subset_sum - sum;
+    if (sum == 0) return true;
+    return get_bit(bit_array, length, sum - 1);
+#endif
+}
+
+/**
+ *  Printed subsets are formatted into a result_buffer (each tester has its own, so there is one per thread) instead of
+ *  with a fprintf for every part of the line (and every bit) and a fflush for every subset.  The buffer is only written
+ *  to its output file by flush_results, which is done at checkpoints (see test_subsets_in_order), at the end of each
+ *  run or chunk, and when it fills up.
+ */
+const unsigned int RESULT_BUFFER_SIZE = 1 << 20;
+
+struct result_buffer {
+    char *data;
+    unsigned int used;
+    FILE *output;
+};
+
+inline void new_result_buffer(result_buffer &results, FILE *output) {
+    results.data = new char[RESULT_BUFFER_SIZE];
+    results.used = 0;
+    results.output = output;
+}
+
+/**
+ *  Writes out everything in the buffer.
+ */
+inline void flush_results(result_buffer &results) {
+#ifdef RUN_STATS
+    double start = stats_time();
+#endif
+    if (results.used > 0) fwrite(results.data, 1, results.used, results.output);
+    results.used = 0;
+    fflush(results.output);
+
+#ifdef RUN_STATS
+    COUNT_STAT(output_writes, 1);
+    COUNT_STAT(output_seconds, stats_time() - start);
+#endif
+}
+
+inline void delete_result_buffer(result_buffer &results) {
+    flush_results(results);
+    delete [] results.data;
+}
+
+static inline void append_results(result_buffer &results, const char *text, const unsigned int length) {
+    if (results.used + length > RESULT_BUFFER_SIZE) {
+        flush_results(results);
+
+        if (length > RESULT_BUFFER_SIZE) {
+            fwrite(text, 1, length, results.output);
+            return;
+        }
+    }
+
+    memcpy(results.data + results.used, text, length);
+    results.used += length;
+}
+
+static inline void append_string(result_buffer &results, const char *text) {
+    append_results(results, text, strlen(text));
+}
+
+static inline void append_char(result_buffer &results, const char c) {
+    if (results.used == RESULT_BUFFER_SIZE) flush_results(results);
+    results.data[results.used++] = c;
+}
+
+/**
+ *  For the short formatted parts of a line (anything up to 255 characters).
+ */
+static inline void append_printf(result_buffer &results, const char *format, ...) {
+    char text[256];
+    va_list arguments;
+
+    va_start(arguments, format);
+    int length = vsnprintf(text, sizeof(text), format, arguments);
+    va_end(arguments);
+
+    if (length >= (int)sizeof(text)) length = sizeof(text) - 1;
+    if (length > 0) append_results(results, text, length);
+}
+
+/**
+ *  bit_characters[b] is the 8 bits of b as '0' and '1' characters, highest bit first, and reversed_bit_characters[b] has
+ *  them lowest bit first, so bitsets can be formatted 8 bits at a time.
+ */
+template <typename unused_t>
+struct bit_character_tables_t {
+    static char bit_characters[256][8];
+    static char reversed_bit_characters[256][8];
+};
+
+template <typename unused_t> char bit_character_tables_t<unused_t>::bit_characters[256][8];
+template <typename unused_t> char bit_character_tables_t<unused_t>::reversed_bit_characters[256][8];
+
+typedef bit_character_tables_t<void> bit_character_tables;
+
+inline void init_bit_characters() {
+    for (unsigned int b = 0; b < 256; b++) {
+        for (unsigned int i = 0; i < 8; i++) {
+            bit_character_tables::bit_characters[b][i] = ((b >> (7 - i)) & 1) ? '1' : '0';
+            bit_character_tables::reversed_bit_characters[b][i] = ((b >> i) & 1) ? '1' : '0';
+        }
+    }
+}
+
+/**
+ *  Returns the bits first_bit ... first_bit + 7 of a bit array (with the most significant element first), with
+ *  first_bit as the lowest bit.  Bits past the end are 0.
+ */
+template <typename word_t>
+static inline unsigned int get_byte(const word_t *bit_array, const unsigned int length, const unsigned int first_bit) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    unsigned int pos = first_bit / element_size;
+    unsigned int shift = first_bit % element_size;
+
+    if (pos >= length) return 0;
+
+    word_t bits = bit_array[length - pos - 1] >> shift;
+    if (shift > element_size - 8 && pos + 1 < length) bits |= bit_array[length - pos - 2] << (element_size - shift);
+    return (unsigned int)(bits & 0xFF);
+}
+
+/**
+ *  Writes the bits first_bit ... first_bit + count - 1 of a bit array to line as '0' and '1' characters, highest bit
+ *  first if high_first is true and lowest bit first otherwise.
+ */
+template <typename word_t>
+static void format_bits(char *line, const word_t *bit_array, const unsigned int length, const unsigned int first_bit, const unsigned int count, const bool high_first) {
+    unsigned int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        unsigned int byte = get_byte(bit_array, length, first_bit + i);
+
+        if (high_first) memcpy(line + (count - i - 8), bit_character_tables::bit_characters[byte], 8);
+        else            memcpy(line + i, bit_character_tables::reversed_bit_characters[byte], 8);
+    }
+
+    for (; i < count; i++) {
+        char c = get_bit(bit_array, length, first_bit + i) ? '1' : '0';
+
+        if (high_first) line[count - i - 1] = c;
+        else            line[i] = c;
+    }
+}
+
+/**
+ *  Writes the sums 1 to bits of a subset (adding up to subset_sum) to line, highest first, as has_sum would give them.
+ *  Without -DFULL_RANGE_SUMS the sums over half of subset_sum are the sums under half of it in reverse.
+ */
+template <typename word_t>
+static void format_sums(char *line, const word_t *bit_array, const unsigned int length, const unsigned int subset_sum, const unsigned int bits) {
+#ifdef FULL_RANGE_SUMS
+    format_bits(line, bit_array, length, 0, bits, true);
+#else
+    unsigned int direct = (subset_sum / 2 < bits) ? subset_sum / 2 : bits;
+    unsigned int top = (subset_sum < bits) ? subset_sum : bits;
+
+    memset(line, '0', bits - top);
+
+    /**
+     *  The sums direct + 1 to top (at line[bits - top] onwards) are the sums subset_sum - top up to subset_sum - direct - 1,
+     *  where the sum 0 is always there.
+     */
+    char *mirrored = line + (bits - top);
+    unsigned int mirrored_count = top - direct;
+    unsigned int lowest = subset_sum - top;
+
+    if (mirrored_count > 0 && lowest == 0) {
+        *mirrored++ = '1';
+        mirrored_count--;
+        lowest = 1;
+    }
+    format_bits(mirrored, bit_array, length, lowest - 1, mirrored_count, false);
+
+    format_bits(line + (bits - direct), bit_array, length, 0, direct, true);
+#endif
+}
+
+/**
+ *  Print the bits in a word.  Note this prints out from right to left (not left to right)
+ */
+template <typename word_t>
+void print_bits(result_buffer &results, const word_t number) {
+    for (int shift = sizeof(word_t) * 8 - 8; shift >= 0; shift -= 8) {
+        append_results(results, bit_character_tables::bit_characters[(number >> shift) & 0xFF], 8);
+    }
+}
+
+/**
+ * Print out the lowest bits bits of an array of bits
+ */
+template <typename word_t>
+void print_bit_array(result_buffer &results, char *line, const word_t *bit_array, const unsigned int bit_array_length, const unsigned int bits) {
+    format_bits(line, bit_array, bit_array_length, 0, bits, true);
+    append_results(results, line, bits);
+}
+
+/**
+ *  Print out the sums 1 to bits of a subset (adding up to subset_sum), highest first.  line is scratch space for the
+ *  bits characters.
+ */
+template <typename word_t>
+void print_sums(result_buffer &results, char *line, const word_t *bit_array, const unsigned int bit_array_length, const unsigned int subset_sum, const unsigned int bits) {
+    format_sums(line, bit_array, bit_array_length, subset_sum, bits);
+    append_results(results, line, bits);
+}
+
+/**
+ *  Print out a number right aligned in width characters
+ */
+static inline void print_unsigned(result_buffer &results, unsigned int number, const unsigned int width) {
+    char digits[16];
+    unsigned int count = 0;
+
+    do {
+        digits[count++] = '0' + (number % 10);
+        number /= 10;
+    } while (number > 0);
+
+    for (unsigned int i = count; i < width; i++) append_char(results, ' ');
+    while (count > 0) append_char(results, digits[--count]);
+}
+
+/**
+ *  Print out all the elements in a subset
+ */
+inline void print_subset(result_buffer &results, const unsigned int *subset, const unsigned int subset_size) {
+#ifndef HTML_OUTPUT
+    append_char(results, '[');
+    for (unsigned int i = 0; i < subset_size; i++) {
+        print_unsigned(results, subset[i], 4);
+    }
+    append_char(results, ']');
+#else
+    append_char(results, '[');
+    for (unsigned int i = 0; i < subset_size; i++) {
+        double whitespaces = (report_widths::max_set_digits - floor(log10(subset[i]))) - 1;
+
+        for (int j = 0; j < whitespaces; j++) append_string(results, "&nbsp;");
+
+        print_unsigned(results, subset[i], 0);
+    }
+    append_char(results, ']');
+#endif
+}
+
+/**
+ * Print out the sums 1 to msl of a subset (adding up to subset_sum), coloring the required subsets green, if there is a missing sum (a 0) it is colored red
+ */
+template <typename word_t>
+void print_bit_array_color(result_buffer &results, char *line, const word_t *bit_array, unsigned long int max_sums_length, unsigned int subset_sum, unsigned int msl, unsigned int min, unsigned int max) {
+#ifndef HTML_OUTPUT
+    const char *green = "\e[32m";
+    const char *red_zero = "\e[31m0\e[32m";
+    const char *color_off = "\e[0m";
+#else
+    const char *green = "<b><span class=\"courier_green\">";
+    const char *red_zero = "<span class=\"courier_red\">0</span>";
+    const char *color_off = "</span></b>";
+#endif
+
+    format_sums(line, bit_array, max_sums_length, subset_sum, msl);
+
+    bool red_on = false;
+
+    for (unsigned int count = 0; count < msl; count++) {
+        if ((msl - min) == count) {
+            red_on = true;
+            append_string(results, green);
+        }
+
+        if (red_on && line[count] == '0') append_string(results, red_zero);
+        else append_char(results, line[count]);
+
+        if ((msl - max) == count) {
+            append_string(results, color_off);
+            red_on = false;
+        }
+    }
+}
+
+/**
+ *  Print out the line for a tested subset (ranked rank, adding up to subset_sum, with M as its last element): its rank,
+ *  its elements, its sums 1 to bits, the range of sums which had to be there and if it passed.  line is scratch space
+ *  for the bits characters.
+ */
+template <typename word_t>
+void print_tested_subset(result_buffer &results, char *line, const subset_rank_t rank, const unsigned int *subset, const unsigned int subset_size, const word_t *sums, const unsigned int length, const unsigned int subset_sum, const unsigned int bits, const bool success) {
+    char rank_string[RANK_STRING_LENGTH];
+    rank_to_string(rank, rank_string);
+
+#ifdef HTML_OUTPUT
+    double whitespaces = report_widths::max_digits - strlen(rank_string);
+
+    for (int i = 0; i < whitespaces; i++) append_string(results, "&nbsp;");
+#endif
+
+#ifndef HTML_OUTPUT
+    append_printf(results, "%15s ", rank_string);
+#else
+    append_printf(results, "%s ", rank_string);
+#endif
+    print_subset(results, subset, subset_size);
+    append_string(results, " = ");
+
+    unsigned int M = subset[subset_size - 1];
+    unsigned int min = subset_sum - M;
+    unsigned int max = M;
+#ifdef ENABLE_COLOR
+    print_bit_array_color(results, line, sums, length, subset_sum, bits, min, max);
+#else 
+    print_sums(results, line, sums, length, subset_sum, bits);
+#endif
+
+    append_printf(results, "  match %4u to %4u ", min, max);
+#ifndef HTML_OUTPUT
+#ifdef ENABLE_COLOR
+    if (success)    append_string(results, " = \e[32mpass\e[0m\n");
+    else            append_string(results, " = \e[31mfail\e[0m\n");
+#else
+    if (success)    append_string(results, " = pass\n");
+    else            append_string(results, " = fail\n");
+#endif
+#else
+    if (success)    append_string(results, " = <span class=\"courier_green\">pass</span><br>\n");
+    else            append_string(results, " = <span class=\"courier_red\">fail</span><br>\n");
+#endif
+}
+
+/**
+ *  The start of a report: the HTML head (with -DHTML_OUTPUT), then M and N.  Nothing is printed if the report is being
+ *  continued from a checkpoint.
+ */
+inline void print_report_start(FILE *output, const unsigned long max_set_value, const unsigned long subset_size, const bool started_from_checkpoint) {
+    if (started_from_checkpoint) return;
+
+#ifdef HTML_OUTPUT
+    fprintf(output, "<!DOCTYPE html PUBLIC \"-//w3c//dtd html 4.0 transitional//en\">\n");
+    fprintf(output, "<html>\n");
+    fprintf(output, "<head>\n");
+    fprintf(output, "  <meta http-equiv=\"Content-Type\"\n");
+    fprintf(output, " content=\"text/html; charset=iso-8859-1\">\n");
+    fprintf(output, "  <meta name=\"GENERATOR\"\n");
+    fprintf(output, " content=\"Mozilla/4.76 [en] (X11; U; Linux 2.4.2-2 i686) [Netscape]\">\n");
+    fprintf(output, "  <title>%lu choose %lu</title>\n", max_set_value, subset_size);
+    fprintf(output, "\n");
+    fprintf(output, "<style type=\"text/css\">\n");
+    fprintf(output, "    .courier_green {\n");
+    fprintf(output, "        color: #008000;\n");
+    fprintf(output, "    }   \n");
+    fprintf(output, "</style>\n");
+    fprintf(output, "<style type=\"text/css\">\n");
+    fprintf(output, "    .courier_red {\n");
+    fprintf(output, "        color: #FF0000;\n");
+    fprintf(output, "    }   \n");
+    fprintf(output, "</style>\n");
+    fprintf(output, "\n");
+    fprintf(output, "</head><body>\n");
+    fprintf(output, "<h1>%lu choose %lu</h1>\n", max_set_value, subset_size);
+    fprintf(output, "<hr width=\"100%%\">\n");
+    fprintf(output, "\n");
+    fprintf(output, "<br>\n");
+    fprintf(output, "<tt>\n");
+#endif
+
+#ifndef HTML_OUTPUT
+    fprintf(output, "max_set_value: %lu, subset_size: %lu\n", max_set_value, subset_size);
+#else
+    fprintf(output, "max_set_value: %lu, subset_size: %lu<br>\n", max_set_value, subset_size);
+#endif
+}
+
+/**
+ *  Sets the widths the ranks and elements are padded to in HTML reports.
+ */
+inline void init_report_widths(const unsigned long max_set_value, const subset_rank_t expected_total) {
+#ifdef HTML_OUTPUT
+    report_widths::max_set_digits = ceil(log10(max_set_value)) + 1;
+    report_widths::max_digits = ceil(log10((double)expected_total));
+#endif
+}
+
+inline void print_report_evaluations(FILE *output, const char *evaluations_string) {
+#ifndef HTML_OUTPUT
+    fprintf(output, "performing %s set evaluations.\n", evaluations_string);
+#else
+    fprintf(output, "performing %s set evaluations.<br>\n", evaluations_string);
+#endif
+}
+
+/**
+ *  The pass and fail counts at the end of a report.
+ */
+inline void print_report_totals(FILE *output, const bool doing_slice, const char *subsets_to_calculate_string, const char *expected_total_string, const unsigned long long pass, const unsigned long long fail) {
+#ifndef HTML_OUTPUT
+    if (doing_slice) {
+        fprintf(output, "expected to compute %s sets\n", subsets_to_calculate_string);
+    } else {
+        fprintf(output, "the expected total number of sets is: %s\n", expected_total_string);
+    }
+    fprintf(output, "%llu total sets, %llu sets passed, %llu sets failed, %lf success rate.\n", pass + fail, pass, fail, ((double)pass / ((double)pass + (double)fail)));
+#else
+    if (doing_slice) {
+        fprintf(output, "expected to compute %s sets<br>\n", subsets_to_calculate_string);
+    } else {
+        fprintf(output, "the expected total number of sets is: %s<br>\n", expected_total_string);
+    }
+    fprintf(output, "%llu total sets, %llu sets passed, %llu sets failed, %lf success rate.<br>\n", pass + fail, pass, fail, ((double)pass / ((double)pass + (double)fail)));
+#endif
+}
+
+inline void print_report_end(FILE *output) {
+#ifdef HTML_OUTPUT
+    fprintf(output, "</tt>\n");
+    fprintf(output, "<br>\n");
+    fprintf(output, "\n");
+    fprintf(output, "<hr width=\"100%%\">\n");
+    fprintf(output, "Copyright &copy; Travis Desell, Tom O'Neil and the University of North Dakota, 2012\n");
+    fprintf(output, "</body>\n");
+    fprintf(output, "</html>\n");
+#endif
+}
+
+#endif
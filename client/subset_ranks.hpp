@@ -0,0 +1,481 @@
+#ifndef SUBSET_SUM_SUBSET_RANKS_HPP
+#define SUBSET_SUM_SUBSET_RANKS_HPP
+
+#include <climits>
+#include <cstdlib>
+
+/**
+ *  Ranking and listing the subsets tested: each subset has M as its largest element, and N - 1 free elements from
+ *  1 ... M - 1, so there are (M - 1) choose (N - 1) of them.  This is shared by the client and render_failed_sets (which
+ *  rebuilds the failed subsets from their ranks).
+ */
+
+/**
+ *  Subsets are ranked by their position in the (lexicographic) list of all subsets.  Ranks are 128 bit where the
+ *  compiler supports it, so slices can be made for problems with up to 2^128 subsets, and 64 bit otherwise.  The
+ *  number of subsets tested in a single run (and the pass and fail counts) are still 64 bit.
+ */
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 subset_rank_t;
+#else
+typedef unsigned long long subset_rank_t;
+#endif
+
+const unsigned int RANK_BITS = sizeof(subset_rank_t) * 8;
+const subset_rank_t MAX_RANK = ~((subset_rank_t)0);
+
+/**
+ *  Enough characters for any rank in decimal, and the terminating null.
+ */
+const unsigned int RANK_STRING_LENGTH = 41;
+
+/**
+ *  Writes rank in decimal to buffer (which must hold RANK_STRING_LENGTH characters), and returns buffer.  Once what's
+ *  left of the rank fits in 64 bits, the (much faster) 64 bit division is used.
+ */
+static inline char* rank_to_string(subset_rank_t rank, char *buffer) {
+    char digits[RANK_STRING_LENGTH];
+    unsigned int count = 0;
+
+    while (rank > ULLONG_MAX) {
+        digits[count++] = '0' + (char)(rank % 10);
+        rank /= 10;
+    }
+
+    unsigned long long low = (unsigned long long)rank;
+    do {
+        digits[count++] = '0' + (char)(low % 10);
+        low /= 10;
+    } while (low > 0);
+
+    for (unsigned int i = 0; i < count; i++) buffer[i] = digits[count - i - 1];
+    buffer[count] = '\0';
+    return buffer;
+}
+
+/**
+ *  Reads a rank in decimal from string, returning false if it isn't a number or doesn't fit in a subset_rank_t.
+ */
+static inline bool parse_rank(const char *string, subset_rank_t &rank) {
+    rank = 0;
+    if (*string == '\0') return false;
+
+    for (; *string != '\0'; string++) {
+        if (*string < '0' || *string > '9') return false;
+
+        subset_rank_t digit = *string - '0';
+        if (rank > (MAX_RANK - digit) / 10) return false;
+        rank = (rank * 10) + digit;
+    }
+    return true;
+}
+
+/**
+ *  Pascal's triangle, where values[(n * (max_k + 1)) + k] is n choose k, for n up to max_n and k up to max_k.
+ *  Binomials too big for a subset_rank_t are MAX_RANK.
+ *
+ *  The headers are used from more than one file (eg with subset_sum_checker.hpp as a library), so state shared by the
+ *  whole process is kept in the static members of a class template, which (unlike a global defined in a header) can
+ *  be defined in every file without them clashing when linked, as C++98 has no inline variables.
+ */
+template <typename unused_t>
+struct binomial_table_t {
+    static subset_rank_t *values;
+    static unsigned int max_n;
+    static unsigned int max_k;
+};
+
+template <typename unused_t> subset_rank_t *binomial_table_t<unused_t>::values = NULL;
+template <typename unused_t> unsigned int binomial_table_t<unused_t>::max_n = 0;
+template <typename unused_t> unsigned int binomial_table_t<unused_t>::max_k = 0;
+
+typedef binomial_table_t<void> binomial_table;
+
+inline void init_binomials(const unsigned int max_n, const unsigned int max_k) {
+    subset_rank_t *values = new subset_rank_t[((size_t)max_n + 1) * ((size_t)max_k + 1)];
+
+    for (unsigned int n = 0; n <= max_n; n++) {
+        subset_rank_t *row = values + ((size_t)n * (max_k + 1));
+        subset_rank_t *previous_row = row - (max_k + 1);
+
+        row[0] = 1;
+        for (unsigned int k = 1; k <= max_k; k++) {
+            if (k > n) {
+                row[k] = 0;
+            } else if (previous_row[k - 1] > MAX_RANK - previous_row[k]) {
+                row[k] = MAX_RANK;
+            } else {
+                row[k] = previous_row[k - 1] + previous_row[k];
+            }
+        }
+    }
+
+    binomial_table::values = values;
+    binomial_table::max_n = max_n;
+    binomial_table::max_k = max_k;
+}
+
+/**
+ *  Makes sure the table covers n up to max_n and k up to max_k, making it again (big enough for the sizes it had as
+ *  well) if it doesn't, so a process testing a lot of different M and N (eg the client's --daemon) only makes it when
+ *  it needs to grow.  If the bigger table can't be allocated (std::bad_alloc is thrown), the old one is kept.
+ */
+inline void reserve_binomials(unsigned int max_n, unsigned int max_k) {
+    subset_rank_t *old_values = binomial_table::values;
+    if (old_values != NULL) {
+        if (max_n <= binomial_table::max_n && max_k <= binomial_table::max_k) return;
+
+        if (max_n < binomial_table::max_n) max_n = binomial_table::max_n;
+        if (max_k < binomial_table::max_k) max_k = binomial_table::max_k;
+    }
+    init_binomials(max_n, max_k);
+    delete [] old_values;
+}
+
+/**
+ *  Looks up n choose k in the table made by init_binomials.
+ */
+static inline subset_rank_t n_choose_k(unsigned int n, unsigned int k) {
+    if (k > n) return 0;
+    return binomial_table::values[((size_t)n * (binomial_table::max_k + 1)) + k];
+}
+
+static inline unsigned int greatest_common_divisor(unsigned int a, unsigned int b) {
+    while (b != 0) {
+        unsigned int remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+/**
+ *  Works out n choose k without the table (MAX_RANK if it is too big), so the size of a problem can be checked before
+ *  making a table for it.  Each step goes from n choose i to n choose (i + 1) = (n choose i) * (n - i) / (i + 1),
+ *  taking out the common factor g of (n choose i) and i + 1 first so the product is exact (and (i + 1) / g always
+ *  divides n - i).
+ */
+inline subset_rank_t binomial(const unsigned int n, unsigned int k) {
+    if (k > n) return 0;
+    if (k > n - k) k = n - k;
+
+    subset_rank_t value = 1;
+    for (unsigned int i = 0; i < k; i++) {
+        unsigned int g = greatest_common_divisor((unsigned int)(value % (i + 1)), i + 1);
+        subset_rank_t factor = (n - i) / ((i + 1) / g);
+
+        value /= g;
+        if (value > MAX_RANK / factor) return MAX_RANK;
+        value *= factor;
+    }
+    return value;
+}
+
+/**
+ *  Sets subset to the subset ranked i, with a table lookup for each of the values up to max_set_value.
+ */
+static inline void generate_ith_subset(subset_rank_t i, unsigned int *subset, unsigned int subset_size, unsigned int max_set_value) {
+    unsigned int pos = 0;
+    unsigned int current_value = 1;
+    subset_rank_t nck;
+
+    while (pos < subset_size - 1) {
+        nck = n_choose_k((max_set_value - 1) - current_value, (subset_size - 1) - (pos + 1));
+
+        if (i < nck) {
+            subset[pos] = current_value;
+            pos++;
+        } else {
+            i -= nck;
+        }
+        current_value++;
+    }
+
+    subset[subset_size - 1] = max_set_value;
+}
+
+/**
+ *  Moves subset to the next subset (in lexicographic order), returning the position of the first element that changed.
+ */
+static inline unsigned int generate_next_subset_td(unsigned int *subset, unsigned int subset_size, unsigned int max_set_value) {
+    unsigned int current = subset_size - 2;
+    subset[current]++;
+
+//    fprintf(output_target, "subset_size: %u, max_set_value: %u\n", subset_size, max_set_value);
+
+//    print_subset(subset, subset_size);
+//    fprintf(output_target, "\n");
+
+    while (current > 0 && subset[current] > (max_set_value - (subset_size - (current + 1)))) {
+        subset[current - 1]++;
+        current--;
+
+//        print_subset(subset, subset_size);
+//        fprintf(output_target, "\n");
+    }
+
+    unsigned int changed_from = current;
+
+    while (current < subset_size - 2) {
+        subset[current + 1] = subset[current] + 1;
+        current++;
+
+//        print_subset(subset, subset_size);
+//        fprintf(output_target, "\n");
+    }
+
+    subset[subset_size - 1] = max_set_value;
+
+//    print_subset(subset, subset_size);
+//    fprintf(output_target, "\n");
+
+    return changed_from;
+}
+
+/**
+ * Jun: changes start
+ * This algorithm keeps track of the bubbles between two adjacent elements in a subset.
+ * Notion: N = subset_size; M = max_set_value; k = N - 1 is the number of free elements (the ones before M),
+ * which are chosen from 1 to M - 1.
+ * There are (k+1) bubbles: bubbles[0] = subset[0] - 1 before the first element, bubbles[i] = subset[i] - subset[i-1] - 1
+ * between two adjacent free elements, and bubbles[k] = (M - 1) - subset[k-1] after the last one, so they add up to M - N.
+ * Initially, the bubbles are initialized with bubbles[0] = M-N, and bubbles[1]=...=bubbles[k]=0.
+ * Bubbles are gradually squeezed from left to right.
+ * The process ends when bubbles[0]=...=bubbles[k-1]=0, and bubbles[k]=M-N.
+ * This lists the subsets in reverse lexicographic order.  Returns the position of the first element that changed.
+ */
+static inline unsigned int generate_next_subset_jl(unsigned int *subset, unsigned int subset_size, unsigned int max_set_value, unsigned int *bubbles) {
+    unsigned int k = subset_size - 1;
+    unsigned int index = k - 1;
+
+    // Find the last bubble (before the one after the last element) which can be squeezed
+    while (bubbles[index] == 0) {
+        index--;
+    }
+
+    // Move one space from it to the next bubble, along with everything after the last element
+    unsigned int tail = bubbles[k];
+    bubbles[k] = 0;
+    bubbles[index]--;
+    bubbles[index + 1] = tail + 1;
+
+    // write the subset under new bubbles
+    for (unsigned int i = index; i < k; i++) {
+        subset[i] = ((i == 0) ? 0 : subset[i - 1]) + bubbles[i] + 1;
+    }
+
+    return index;
+}
+
+/**
+ *  Revolving door order (Kreher and Stinson, Combinatorial Algorithms, section 2.3.3) lists the free elements of the
+ *  subsets (the k = subset_size - 1 elements before M, chosen from 1 to n = M - 1) so that each differs from the one
+ *  before it by swapping out a single element.  The free elements are kept in increasing order in door[1] ... door[k],
+ *  with door[k + 1] = M after them, so door + 1 is the whole subset.  door[0] is scratch space.
+ *
+ *  Sets door to the subset ranked i in revolving door order.
+ */
+static inline void generate_ith_subset_rd(subset_rank_t i, unsigned int *door, const unsigned int k, const unsigned int n) {
+    unsigned int x = n;
+
+    for (unsigned int j = k; j >= 1; j--) {
+        while (n_choose_k(x, j) > i) x--;
+        door[j] = x + 1;
+        i = n_choose_k(x + 1, j) - i - 1;
+    }
+
+    door[k + 1] = n + 1;
+}
+
+/**
+ *  Moves door to the next subset in revolving door order, setting removed and added to the elements which were swapped.
+ */
+static inline void generate_next_subset_rd(unsigned int *door, const unsigned int k, const unsigned int n, unsigned int &removed, unsigned int &added) {
+    unsigned int j = 1;
+    while (j <= k && door[j] == j) j++;
+
+    if (((k - j) & 1) == 1) {
+        if (j == 1) {
+            removed = door[1];
+            added = door[1] - 1;
+            door[1]--;
+        } else {
+            removed = (j > 2) ? j - 2 : 1;
+            added = j;
+            door[j - 1] = j;
+            if (j > 2) door[j - 2] = j - 1;
+        }
+    } else {
+        if (door[j + 1] != door[j] + 1) {
+            removed = (j > 1) ? j - 1 : door[j];
+            added = door[j] + 1;
+            door[j - 1] = door[j];
+            door[j]++;
+        } else {
+            removed = (j < k) ? door[j] + 1 : door[j];
+            added = j;
+            door[j + 1] = door[j];
+            door[j] = j;
+        }
+    }
+
+    door[k + 1] = n + 1;
+}
+
+/**
+ *  The orders the subsets can be tested in (picked with --order).
+ */
+enum subset_order { LEXICOGRAPHIC_ORDER, JUN_LIU_ORDER, REVOLVING_DOOR_ORDER, SUBSET_ORDERS };
+
+const char * const subset_order_names[SUBSET_ORDERS] = { "lexicographic", "jun_liu", "revolving_door" };
+
+/**
+ *  Lists the subsets in one of the orders, where the rank of a subset is its position in that order:
+ *
+ *      seek(rank)                  moves to the subset ranked rank.
+ *      next()                      moves to the next subset.
+ *      changed_from_position()     the position of the first element that changed in the last move (0 after a seek),
+ *                                  so the sums stack only needs to be recalculated from there.
+ *      done()                      true once it has moved past the last subset.
+ *
+ *  subset is the current subset (with M last).  Each enumerator also has a static sweeps_last_element, which is true if
+ *  the subsets with the same prefix come one after another with their last free element going up by one each time, so
+ *  they can be tested in a last element sweep (see start_sweep).
+ *
+ *  The subset_order enum and new_subset_enumerator need updating when adding another order.
+ */
+struct subset_enumerator {
+    unsigned int *subset;
+    unsigned int subset_size;
+    unsigned int max_set_value;
+    subset_rank_t rank;
+    subset_rank_t total;
+    unsigned int changed_from;
+
+    subset_enumerator(const unsigned int max_set_value, const unsigned int subset_size) :
+        subset(NULL), subset_size(subset_size), max_set_value(max_set_value), rank(0), total(n_choose_k(max_set_value - 1, subset_size - 1)), changed_from(0) {
+    }
+
+    virtual ~subset_enumerator() {
+    }
+
+    virtual void seek(const subset_rank_t rank) = 0;
+    virtual void next() = 0;
+
+    unsigned int changed_from_position() const {
+        return changed_from;
+    }
+
+    bool done() const {
+        return rank >= total;
+    }
+};
+
+/**
+ *  Lexicographic order, using generate_ith_subset and generate_next_subset_td.
+ */
+struct lexicographic_enumerator : public subset_enumerator {
+    static const bool sweeps_last_element = true;
+
+    lexicographic_enumerator(const unsigned int max_set_value, const unsigned int subset_size) : subset_enumerator(max_set_value, subset_size) {
+        subset = new unsigned int[subset_size];
+    }
+
+    ~lexicographic_enumerator() {
+        delete [] subset;
+    }
+
+    void seek(const subset_rank_t rank) {
+        this->rank = rank;
+        changed_from = 0;
+        if (rank < total) generate_ith_subset(rank, subset, subset_size, max_set_value);
+    }
+
+    void next() {
+        if (++rank < total) changed_from = generate_next_subset_td(subset, subset_size, max_set_value);
+    }
+};
+
+/**
+ *  Reverse lexicographic order, using Jun's bubbles (generate_next_subset_jl).  Seeking goes through the lexicographic
+ *  rank, then works out the bubbles from the subset.
+ */
+struct jun_liu_enumerator : public subset_enumerator {
+    static const bool sweeps_last_element = false;
+    unsigned int *bubbles;
+
+    jun_liu_enumerator(const unsigned int max_set_value, const unsigned int subset_size) : subset_enumerator(max_set_value, subset_size) {
+        subset = new unsigned int[subset_size];
+        bubbles = new unsigned int[subset_size];
+    }
+
+    ~jun_liu_enumerator() {
+        delete [] subset;
+        delete [] bubbles;
+    }
+
+    void seek(const subset_rank_t rank) {
+        this->rank = rank;
+        changed_from = 0;
+        if (rank >= total) return;
+
+        generate_ith_subset(total - 1 - rank, subset, subset_size, max_set_value);
+
+        unsigned int k = subset_size - 1;
+        for (unsigned int i = 0; i < k; i++) bubbles[i] = subset[i] - ((i == 0) ? 0 : subset[i - 1]) - 1;
+        bubbles[k] = max_set_value - ((k == 0) ? 0 : subset[k - 1]) - 1;
+    }
+
+    void next() {
+        if (++rank < total) changed_from = generate_next_subset_jl(subset, subset_size, max_set_value, bubbles);
+    }
+};
+
+/**
+ *  Revolving door order, using generate_ith_subset_rd and generate_next_subset_rd.  removed and added are the elements
+ *  swapped by the last next().
+ */
+struct revolving_door_enumerator : public subset_enumerator {
+    static const bool sweeps_last_element = false;
+    unsigned int *door;
+    unsigned int removed;
+    unsigned int added;
+
+    revolving_door_enumerator(const unsigned int max_set_value, const unsigned int subset_size) : subset_enumerator(max_set_value, subset_size), removed(0), added(0) {
+        door = new unsigned int[subset_size + 1];
+        subset = door + 1;
+    }
+
+    ~revolving_door_enumerator() {
+        delete [] door;
+    }
+
+    void seek(const subset_rank_t rank) {
+        this->rank = rank;
+        changed_from = 0;
+        if (rank < total) generate_ith_subset_rd(rank, door, subset_size - 1, max_set_value - 1);
+    }
+
+    void next() {
+        if (++rank >= total) return;
+
+        generate_next_subset_rd(door, subset_size - 1, max_set_value - 1, removed, added);
+
+        unsigned int smallest = (removed < added) ? removed : added;
+        changed_from = 0;
+        while (subset[changed_from] < smallest) changed_from++;
+    }
+};
+
+/**
+ *  Returns a new enumerator for order, which needs init_binomials to have been called.
+ */
+inline subset_enumerator* new_subset_enumerator(const subset_order order, const unsigned int max_set_value, const unsigned int subset_size) {
+    switch (order) {
+        case JUN_LIU_ORDER:         return new jun_liu_enumerator(max_set_value, subset_size);
+        case REVOLVING_DOOR_ORDER:  return new revolving_door_enumerator(max_set_value, subset_size);
+        default:                    return new lexicographic_enumerator(max_set_value, subset_size);
+    }
+}
+
+#endif
@@ -0,0 +1,815 @@
+#ifndef SUBSET_SUM_CHECKER_HPP
+#define SUBSET_SUM_CHECKER_HPP
+
+#include <cstring>
+#include <stdint.h>
+
+#include "shift_or.hpp"
+#include "subset_ranks.hpp"
+#include "run_stats.hpp"
+
+/**
+ *  The core of testing subsets: the sums kernels, the accept filters and the last element sweep, with the state they
+ *  need kept in a subset_sum_checker instead of globals, so a process can have as many checkers as it likes (eg one
+ *  per thread).  check_subsets tests a range of subsets with a checker, handing the failed ones to a subset_sink:
+ *
+ *      init_binomials(M - 1, N - 1);
+ *      select_shift_or_kernel();
+ *
+ *      subset_sum_checker checker;
+ *      new_subset_sum_checker(checker, M, N);
+ *
+ *      subset_range range = { LEXICOGRAPHIC_ORDER, first_rank, count };
+ *      subset_counts counts = check_subsets(checker, range, sink);
+ *
+ *      delete_subset_sum_checker(checker);
+ *
+ *  The binomials and the shift_or kernel are the only things shared between checkers, and are set up once for the
+ *  process (init_binomials with the largest M and N that will be checked).  Everything here (and in the headers it
+ *  includes) is inline, so any number of files in a program can include it (see bin/check_checker_library.sh).
+ *
+ *  The client (subset_sum_main.cpp) tests subsets with the same code, through check_next_subset, adding printing,
+ *  binary records and the VERIFY_* checks around it.
+ */
+
+/**
+ *  The sums bitsets are arrays of sums_word_t.  These are 64 bits unless compiled with -DSUMS_WORD_32, in which case
+ *  they are 32 bits.  verify_word_t is the other size (see -DVERIFY_WORD_WIDTH in the client).
+ */
+#ifdef SUMS_WORD_32
+typedef uint32_t sums_word_t;
+typedef uint64_t verify_word_t;
+#else
+typedef uint64_t sums_word_t;
+typedef uint32_t verify_word_t;
+#endif
+
+const unsigned int ELEMENT_SIZE = sizeof(sums_word_t) * 8;
+
+/**
+ *  In lexicographic order consecutive subsets usually only differ in their last free element (the one before M), so
+ *  unless compiled with -DNO_LAST_ELEMENT_SWEEP, all the values of that element for the same prefix are tested
+ *  together in a last element sweep (see start_sweep).  The other orders are tested without sweeps (see
+ *  check_next_subset).
+ */
+#ifndef NO_LAST_ELEMENT_SWEEP
+#define LAST_ELEMENT_SWEEP
+#endif
+
+/**
+ *  Unless compiled with -DNO_ACCEPT_FILTER, subsets which can be shown to pass from their elements alone (see
+ *  accept_subset) aren't tested with the sums bitsets.  How many subsets each filter accepted is counted in the
+ *  checker's accept_filter_counts.
+ */
+enum accept_filter { ACCEPT_EMPTY_RANGE, ACCEPT_CONTIGUOUS_SUMS, ACCEPT_NONE, ACCEPT_FILTERS };
+
+/**
+ *  Shift all the bits in an array of to the left by shift. src is unchanged, and the result of the shift is put into dest.
+ *  length is the number of elements in dest (and src) which should be the same for both
+ *
+ *  Performs:
+ *      dest = src << shift
+ */
+template <typename word_t>
+static inline void shift_left(word_t *dest, const unsigned int length, const word_t *src, const unsigned int shift) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    unsigned int full_element_shifts = shift / element_size;
+    unsigned int sub_shift = shift % element_size;
+
+    if (full_element_shifts >= length) {
+        for (unsigned int i = 0; i < length; i++) dest[i] = 0;
+        return;
+    }
+
+    /**
+     *  Note that the shift may be more than the length of a word (ie over 32 or 64), this needs to be accounted for, so the element
+     *  we're shifting from may be ahead a few elements in the array.  When we do the shift, we can do this quickly by getting the target bits
+     *  shifted to the left and doing an or with a shift to the right.
+     *  ie (if our elements had 8 bits):
+     *      00011010 101111101
+     *  doing a shift of 5, we could update the first one to:
+     *     00010111         // src[i + (full_element_shifts = 0) + 1] >> ((element_size = 8) - (sub_shift = 5)) // shift right 3
+     *     |
+     *     01000000
+     *  which would be:
+     *     01010111
+     *  then the next would just be the second element shifted to the left by 5:
+     *     10100000
+     *   which results in:
+     *     01010111 10100000
+     *   which is the whole array shifted to the left by 5
+     *
+     *  A sub_shift of 0 is handled separately, as shifting a word right by element_size is undefined.  The
+     *  last full_element_shifts elements of dest are the bits shifted in from the right, so they are zeroed.
+     */
+    if (sub_shift == 0) {
+        for (unsigned int i = 0; i < length - full_element_shifts; i++) {
+            dest[i] = src[i + full_element_shifts];
+        }
+    } else {
+        for (unsigned int i = 0; i < (length - full_element_shifts) - 1; i++) {
+            dest[i] = src[i + full_element_shifts] << sub_shift | src[i + full_element_shifts + 1] >> (element_size - sub_shift);
+        }
+        dest[length - full_element_shifts - 1] = src[length - 1] << sub_shift;
+    }
+
+    for (unsigned int i = length - full_element_shifts; i < length; i++) dest[i] = 0;
+}
+
+/**
+ *  updates dest to:
+ *      dest != src
+ *
+ *  Where dest and src are two arrays with length elements
+ */
+template <typename word_t>
+static inline void or_equal(word_t *dest, const unsigned int length, const word_t *src) {
+    for (unsigned int i = 0; i < length; i++) dest[i] |= src[i];
+}
+
+/**
+ *  Adds the single bit (for a new set element) into dest:
+ *
+ *  dest |= 1 << number
+ */
+template <typename word_t>
+static inline void or_single(word_t *dest, const unsigned int length, const unsigned int number) {
+    unsigned int pos = number / (sizeof(word_t) * 8);
+    unsigned int tmp = number % (sizeof(word_t) * 8);
+
+    dest[length - pos - 1] |= ((word_t)1) << tmp;
+}
+
+/**
+ *  Tests to see if all the bits are 1s between min and max (inclusive), where bit (n - 1) represents the sum n.
+ *  An empty range (min > max) trivially passes.
+ */
+template <typename word_t>
+static inline bool all_ones(const word_t *subset, const unsigned int length, const unsigned int min, const unsigned int max) {
+    if (min > max) return true;
+
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const word_t all = ~((word_t)0);
+
+    unsigned int min_pos = (min - 1) / element_size;
+    unsigned int min_tmp = (min - 1) % element_size;
+    unsigned int max_pos = (max - 1) / element_size;
+    unsigned int max_tmp = (max - 1) % element_size;
+
+    word_t min_against = all << min_tmp;
+    word_t max_against = all >> ((element_size - 1) - max_tmp);
+
+    if (min_pos == max_pos) {
+        word_t against = min_against & max_against;
+        return against == (against & subset[length - max_pos - 1]);
+    }
+
+    if (min_against != (min_against & subset[length - min_pos - 1])) {
+        COUNT_STAT(early_exits, 1);
+        return false;
+    }
+
+    for (unsigned int i = min_pos + 1; i < max_pos; i++) {
+        if (all != subset[length - i - 1]) {
+            COUNT_STAT(early_exits, 1);
+            return false;
+        }
+    }
+
+    return max_against == (max_against & subset[length - max_pos - 1]);
+}
+
+/**
+ *  Returns how many of the length elements of a bitset are needed to hold the sums up to sum.  Bitsets have their
+ *  most significant element first, so these are the last elements of the bitset.
+ */
+template <typename word_t>
+static inline unsigned int live_length(const unsigned int length, const unsigned int sum) {
+    unsigned int live = (sum / (sizeof(word_t) * 8)) + 1;
+    if (live < length) return live;
+    return length;
+}
+
+/**
+ *  Returns the live elements of a bitset holding sums up to sum, setting live to how many there are.
+ */
+template <typename word_t>
+static inline const word_t* live_sums(const word_t *sums, const unsigned int length, const unsigned int sum, unsigned int &live) {
+    live = live_length<word_t>(length, sum);
+    return sums + (length - live);
+}
+
+/**
+ *  Recalculates the sums stack (with length elements per bitset) for a subset, from depth changed_from onwards.  The
+ *  bitset at depth d of the stack starts at sums + (d * length).
+ *
+ *  Only the live elements of each bitset (the ones that can hold a sum of subset[0] ... subset[d], see live_length)
+ *  are calculated.  live[d] is how many elements of the bitset at depth d were calculated last time, and the elements
+ *  in front of them are kept zeroed, so a bitset can be shifted into a longer one without any extra work.  When a
+ *  bitset shrinks, the elements which are no longer live are zeroed.  live should start out as length for every
+ *  depth.
+ */
+template <typename word_t>
+static inline void calculate_sums(word_t *sums, unsigned int *live, const unsigned int length, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from) {
+    unsigned int current;
+    unsigned int sum = 0;
+    unsigned int depth_live;
+    word_t *depth_sums;
+
+    for (unsigned int i = 0; i < changed_from; i++) sum += subset[i];
+
+    for (unsigned int i = changed_from; i < subset_size; i++) {
+        current = subset[i];
+        sum += current;
+        depth_live = live_length<word_t>(length, sum);
+        depth_sums = sums + (i * length) + (length - depth_live);
+
+        for (unsigned int j = live[i]; j > depth_live; j--) depth_sums[(int)depth_live - (int)j] = 0;
+        live[i] = depth_live;
+
+        if (i == 0) {
+            for (unsigned int j = 0; j < depth_live; j++) depth_sums[j] = 0;
+        } else {
+            shift_or(depth_sums, depth_live, depth_sums - length, current);     // sums[i] = sums[i - 1] | (sums[i - 1] << current);
+        }
+
+        or_single(depth_sums, depth_live, current - 1);                        // sums[i] |= 1 << (current - 1);
+    }
+}
+
+/**
+ *  Calculates the sums stack from depth changed_from onwards, and tests if the sums from min to max are all there.
+ */
+typedef bool (*sums_test_function)(sums_word_t *sums, unsigned int *live, const unsigned int length, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const unsigned int min, const unsigned int max);
+
+static inline bool test_sums_generic(sums_word_t *sums, unsigned int *live, const unsigned int length, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const unsigned int min, const unsigned int max) {
+    calculate_sums(sums, live, length, subset, subset_size, changed_from);
+
+    unsigned int max_live = live_length<sums_word_t>(length, max);
+    return all_ones(sums + (subset_size * length) - max_live, max_live, min, max);
+}
+
+/**
+ *  Versions of shift_or and all_ones where the number of elements in the bitset is known at compile time, so the
+ *  loops can be fully unrolled and (for small M) the bitsets kept in registers.  They are branch free: the elements
+ *  shifted in from past the end of the bitset are 0, and (low >> 1) >> (element_size - 1 - sub_shift) gives 0 instead
+ *  of an undefined shift when sub_shift is 0.
+ */
+template <typename word_t, unsigned int LENGTH>
+static inline void shift_or_fixed(word_t *dest, const word_t *src, const unsigned int shift) {
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const unsigned int full_element_shifts = shift / element_size;
+    const unsigned int sub_shift = shift % element_size;
+
+    for (unsigned int i = 0; i < LENGTH; i++) {
+        word_t high = (i + full_element_shifts < LENGTH) ? src[i + full_element_shifts] : 0;
+        word_t low = (i + full_element_shifts + 1 < LENGTH) ? src[i + full_element_shifts + 1] : 0;
+
+        dest[i] = src[i] | high << sub_shift | (low >> 1) >> (element_size - 1 - sub_shift);
+    }
+}
+
+template <typename word_t, unsigned int LENGTH>
+static inline bool all_ones_fixed(const word_t *subset, const unsigned int min, const unsigned int max) {
+    if (min > max) return true;
+
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const word_t all = ~((word_t)0);
+    word_t missing = 0;
+
+    for (unsigned int pos = 0; pos < LENGTH; pos++) {
+        unsigned int first = pos * element_size;
+        unsigned int last = first + element_size - 1;
+
+        word_t against = 0;
+        if ((min - 1) <= last && (max - 1) >= first) {
+            against = all;
+            if ((min - 1) > first) against &= all << ((min - 1) - first);
+            if ((max - 1) < last) against &= all >> (last - (max - 1));
+        }
+
+        missing |= against & ~subset[LENGTH - pos - 1];
+    }
+
+    return missing == 0;
+}
+
+template <typename word_t, unsigned int LENGTH, unsigned int SUBSET_SIZE>
+static bool test_sums_fixed(word_t *sums, unsigned int *live, const unsigned int length, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const unsigned int min, const unsigned int max) {
+    word_t *depth_sums;
+    for (unsigned int i = changed_from; i < SUBSET_SIZE; i++) {
+        depth_sums = sums + (i * LENGTH);
+
+        if (i == 0) {
+            for (unsigned int j = 0; j < LENGTH; j++) depth_sums[j] = 0;
+        } else {
+            shift_or_fixed<word_t, LENGTH>(depth_sums, depth_sums - LENGTH, subset[i]);
+        }
+
+        or_single(depth_sums, LENGTH, subset[i] - 1);
+    }
+
+    return all_ones_fixed<word_t, LENGTH>(sums + ((SUBSET_SIZE - 1) * LENGTH), min, max);
+}
+
+/**
+ *  The fixed length kernels are made for bitsets of 1, 2, 4 and 8 elements, and subsets of 3 to 8 elements.
+ */
+const unsigned int MAX_FIXED_LENGTH = 8;
+
+template <unsigned int LENGTH>
+static sums_test_function select_fixed_sums_test(const unsigned int subset_size) {
+    switch (subset_size) {
+        case 3: return test_sums_fixed<sums_word_t, LENGTH, 3>;
+        case 4: return test_sums_fixed<sums_word_t, LENGTH, 4>;
+        case 5: return test_sums_fixed<sums_word_t, LENGTH, 5>;
+        case 6: return test_sums_fixed<sums_word_t, LENGTH, 6>;
+        case 7: return test_sums_fixed<sums_word_t, LENGTH, 7>;
+        case 8: return test_sums_fixed<sums_word_t, LENGTH, 8>;
+        default: return NULL;
+    }
+}
+
+/**
+ *  Picks the fixed length kernel for this subset size, rounding length up to its bitset size, or the generic kernel
+ *  (leaving length unchanged) if there isn't one.  Bitsets have their most significant element first, so padding
+ *  them with extra (zero) elements at the front doesn't change any of the sums.
+ */
+static inline sums_test_function select_sums_test(unsigned long int &length, const unsigned int subset_size) {
+#ifndef NO_FIXED_KERNELS
+    unsigned int fixed_length = 1;
+    while (fixed_length < length) fixed_length *= 2;
+
+    sums_test_function fixed = NULL;
+    switch (fixed_length) {
+        case 1: fixed = select_fixed_sums_test<1>(subset_size); break;
+        case 2: fixed = select_fixed_sums_test<2>(subset_size); break;
+        case 4: fixed = select_fixed_sums_test<4>(subset_size); break;
+        case MAX_FIXED_LENGTH: fixed = select_fixed_sums_test<MAX_FIXED_LENGTH>(subset_size); break;
+    }
+
+    if (fixed != NULL) {
+        length = fixed_length;
+        return fixed;
+    }
+#endif
+    return test_sums_generic;
+}
+
+/**
+ *  Allocates the live lengths for a sums stack (see calculate_sums), starting out as the whole length.
+ */
+inline unsigned int* new_live_lengths(const unsigned int subset_size, const unsigned int length) {
+    unsigned int *live = new unsigned int[subset_size];
+    for (unsigned int i = 0; i < subset_size; i++) live[i] = length;
+    return live;
+}
+
+/**
+ *  Picks the sums kernel for subsets of subset_size elements up to max_set_value, setting length to the number of
+ *  elements in each of their bitsets.  The bitsets only need to hold half of the largest subset sum (see
+ *  sums_test_max), but always need room for the largest element.
+ */
+static inline sums_test_function select_sums_kernel(const unsigned int max_set_value, const unsigned int subset_size, unsigned long int &length) {
+    unsigned long int max_set_sum = 0;
+    for (unsigned int i = 0; i < subset_size; i++) max_set_sum += max_set_value - i;
+
+#ifdef FULL_RANGE_SUMS
+    unsigned long int max_stored_sum = max_set_sum;
+#else
+    unsigned long int max_stored_sum = max_set_sum / 2;
+    if (max_stored_sum < max_set_value) max_stored_sum = max_set_value;
+#endif
+    length = (max_stored_sum / ELEMENT_SIZE) + 1;
+
+    return select_sums_test(length, subset_size);
+}
+
+/**
+ *  The sums of a subset are symmetric: s can be made if and only if S - s can (where S is the sum of the whole subset),
+ *  so all the sums from M to S - M can be made if all the sums from M to S / 2 can.  Unless compiled with
+ *  -DFULL_RANGE_SUMS, the sums bitsets are only long enough for half of the largest subset sum, anything shifted past
+ *  that is cut off, and only the sums M to S / 2 are tested.  The rest of the sums are found by symmetry (see has_sum)
+ *  when printing.
+ *
+ *  Returns the largest sum that needs to be tested (the smallest is M) for a subset adding up to subset_sum.
+ */
+static inline unsigned int sums_test_max(const unsigned int M, const unsigned int subset_sum) {
+#ifdef FULL_RANGE_SUMS
+    return subset_sum - M;
+#else
+    return subset_sum / 2;
+#endif
+}
+
+/**
+ *  Returns the largest C where all the sums 1 to C can be made from the first count elements of subset (which are in
+ *  increasing order), setting complete to true if every one of them was used.  This is the sum of the elements up to
+ *  the first one which is more than one past the sums before it (the usual complete sequence test).
+ */
+static inline unsigned int contiguous_sums(const unsigned int *subset, const unsigned int count, bool &complete) {
+    unsigned int covered = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        if (subset[i] > covered + 1) {
+            complete = false;
+            return covered;
+        }
+        covered += subset[i];
+    }
+    complete = true;
+    return covered;
+}
+
+/**
+ *  Decides if a subset passes without calculating its sums, where the sums M to max need to be made and covered is
+ *  contiguous_sums of the elements before M.  Returns the filter which accepted it, or ACCEPT_NONE if it needs to be
+ *  tested with the sums bitsets.  Both filters are sufficient (never accept a failing subset):
+ *
+ *      ACCEPT_EMPTY_RANGE:     max < M, so there are no sums to test.
+ *      ACCEPT_CONTIGUOUS_SUMS: the elements before M make every sum 0 to covered, so adding M makes every sum M to
+ *                              M + covered, and M + covered >= max.
+ */
+static inline accept_filter accept_subset(const unsigned int M, const unsigned int max, const unsigned int covered) {
+#ifdef NO_ACCEPT_FILTER
+    return ACCEPT_NONE;
+#else
+    if (max < M) return ACCEPT_EMPTY_RANGE;
+    if (M + covered >= max) return ACCEPT_CONTIGUOUS_SUMS;
+    return ACCEPT_NONE;
+#endif
+}
+
+/**
+ *  Everything needed to test subsets of subset_size elements up to max_set_value.
+ *
+ *  sums is a stack holding one bitset (of length elements) for each position in the subset, where the bitset at depth
+ *  d holds every sum that can be made from subset[0] ... subset[d].  As consecutive subsets usually only differ in
+ *  their last few elements, only the depths from the first changed element need to be recalculated.  Only the elements
+ *  of each bitset which can hold its sums are kept up to date (see calculate_sums and live_sums).
+ */
+struct subset_sum_checker {
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    unsigned long int length;
+    sums_test_function test_sums;
+    sums_word_t *sums;
+    unsigned int *sums_live;
+#ifdef LAST_ELEMENT_SWEEP
+    sums_word_t *sweep_pattern;
+    uint64_t *sweep_passed;
+    unsigned int sweep_count;
+    unsigned int sweep_position;
+    unsigned int sweep_changed_from;
+#endif
+    unsigned int skipped_from;
+    unsigned long long accept_filter_counts[ACCEPT_FILTERS];
+
+    unsigned int allocated_set_value;
+    unsigned int allocated_subset_size;
+    unsigned long int allocated_length;
+};
+
+/**
+ *  Allocates the bitsets for subsets of up to subset_size elements up to max_set_value, with length elements each.
+ */
+static inline void allocate_checker_bitsets(subset_sum_checker &checker, const unsigned int max_set_value, const unsigned int subset_size, const unsigned long int length) {
+    checker.allocated_set_value = max_set_value;
+    checker.allocated_subset_size = subset_size;
+    checker.allocated_length = length;
+
+    checker.sums = new sums_word_t[subset_size * length];
+    checker.sums_live = new unsigned int[subset_size];
+#ifdef LAST_ELEMENT_SWEEP
+    checker.sweep_pattern = new sums_word_t[length];
+    checker.sweep_passed = new uint64_t[(max_set_value / 64) + 1];
+#endif
+}
+
+static inline void free_checker_bitsets(subset_sum_checker &checker) {
+    delete [] checker.sums;
+    delete [] checker.sums_live;
+#ifdef LAST_ELEMENT_SWEEP
+    delete [] checker.sweep_pattern;
+    delete [] checker.sweep_passed;
+#endif
+}
+
+/**
+ *  Sets a checker up for subsets of subset_size elements up to max_set_value, reusing its bitsets if they are big
+ *  enough (they are made bigger if not), so one checker can test a whole table of M and N (see --sweep in the client).
+ *  The accept filter counts are kept.
+ */
+inline void reset_subset_sum_checker(subset_sum_checker &checker, const unsigned int max_set_value, const unsigned int subset_size) {
+    checker.max_set_value = max_set_value;
+    checker.subset_size = subset_size;
+    checker.test_sums = select_sums_kernel(max_set_value, subset_size, checker.length);
+
+    if (max_set_value > checker.allocated_set_value || subset_size > checker.allocated_subset_size || checker.length > checker.allocated_length) {
+        free_checker_bitsets(checker);
+        allocate_checker_bitsets(checker,
+                (max_set_value > checker.allocated_set_value) ? max_set_value : checker.allocated_set_value,
+                (subset_size > checker.allocated_subset_size) ? subset_size : checker.allocated_subset_size,
+                (checker.length > checker.allocated_length) ? checker.length : checker.allocated_length);
+    }
+
+    for (unsigned int i = 0; i < subset_size; i++) checker.sums_live[i] = checker.length;
+#ifdef LAST_ELEMENT_SWEEP
+    checker.sweep_count = 0;
+    checker.sweep_position = 0;
+#endif
+    checker.skipped_from = subset_size;
+}
+
+inline void new_subset_sum_checker(subset_sum_checker &checker, const unsigned int max_set_value, const unsigned int subset_size) {
+    unsigned long int length;
+    select_sums_kernel(max_set_value, subset_size, length);
+    allocate_checker_bitsets(checker, max_set_value, subset_size, length);
+
+    for (unsigned int i = 0; i < ACCEPT_FILTERS; i++) checker.accept_filter_counts[i] = 0;
+    reset_subset_sum_checker(checker, max_set_value, subset_size);
+}
+
+inline void delete_subset_sum_checker(subset_sum_checker &checker) {
+    free_checker_bitsets(checker);
+}
+
+/**
+ *  Returns the bitset in the sums stack holding the sums of subset[0] ... subset[depth]
+ */
+static inline sums_word_t* sums_at_depth(const subset_sum_checker &checker, const unsigned int depth) {
+    return checker.sums + (depth * checker.length);
+}
+
+/**
+ *  Tests a subset with the sums bitsets, returning true if it passes.  The sums stack already holds the sums for
+ *  subset[0] ... subset[changed_from - 1] from the previous subset, so only the depths from changed_from onwards are
+ *  recalculated.  Use a changed_from of 0 for a subset unrelated to the last one tested.
+ */
+static inline bool check_sums(subset_sum_checker &checker, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from) {
+    unsigned int M = subset[subset_size - 1];
+    unsigned int subset_sum = 0;
+    for (unsigned int i = 0; i < subset_size; i++) subset_sum += subset[i];
+
+    bool success = checker.test_sums(checker.sums, checker.sums_live, checker.length, subset, subset_size, changed_from, M, sums_test_max(M, subset_sum));
+
+#ifdef RUN_STATS
+    COUNT_STAT(sums_tests, 1);
+    for (unsigned int i = changed_from; i < subset_size; i++) COUNT_STAT(dp_words, checker.sums_live[i]);
+#endif
+    return success;
+}
+
+#ifdef LAST_ELEMENT_SWEEP
+/**
+ *  Tests to see if all the bits of:
+ *
+ *      pattern | (pattern << shift) | (1 << (shift - 1))
+ *
+ *  are 1s between min and max (inclusive), one element at a time without storing it, so it stops at the first element
+ *  with a missing sum.  max must fit in the length elements of pattern.
+ */
+template <typename word_t>
+static inline bool shifted_all_ones(const word_t *pattern, const unsigned int length, const unsigned int shift, const unsigned int min, const unsigned int max) {
+    if (min > max) return true;
+
+    const unsigned int element_size = sizeof(word_t) * 8;
+    const word_t all = ~((word_t)0);
+    const unsigned int full_element_shifts = shift / element_size;
+    const unsigned int sub_shift = shift % element_size;
+    const unsigned int single_pos = (shift - 1) / element_size;
+
+    unsigned int min_pos = (min - 1) / element_size;
+    unsigned int max_pos = (max - 1) / element_size;
+
+    for (unsigned int pos = min_pos; pos <= max_pos; pos++) {
+        word_t high = (pos >= full_element_shifts) ? pattern[length - (pos - full_element_shifts) - 1] : 0;
+        word_t low = (pos >= full_element_shifts + 1) ? pattern[length - (pos - full_element_shifts - 1) - 1] : 0;
+
+        word_t sums = pattern[length - pos - 1] | high << sub_shift | (low >> 1) >> (element_size - 1 - sub_shift);
+        if (pos == single_pos) sums |= ((word_t)1) << ((shift - 1) % element_size);
+
+        word_t against = all;
+        if (pos == min_pos) against &= all << ((min - 1) % element_size);
+        if (pos == max_pos) against &= all >> ((element_size - 1) - ((max - 1) % element_size));
+
+        if (against != (against & sums)) {
+            COUNT_STAT(dp_words, pos - min_pos + 1);
+            COUNT_STAT(early_exits, pos < max_pos);
+            return false;
+        }
+    }
+
+    COUNT_STAT(dp_words, max_pos - min_pos + 1);
+    return true;
+}
+
+/**
+ *  Tests subset and the subsets after it which only differ in their last free element x = subset[subset_size - 2], up
+ *  to x = M - 1 or remaining subsets, whichever is first.  The results are kept in the checker's sweep_passed mask, and
+ *  handed out one at a time by next_in_sweep.
+ *
+ *  Every subset in the sweep has the same prefix P = subset[0] ... subset[subset_size - 3] (with sum T), so its sums
+ *  are pattern | (pattern << x) | (1 << (x - 1)), where the pattern:
+ *
+ *      pattern = sums(P) | (sums(P) << M) | (1 << (M - 1))
+ *
+ *  is calculated once for the whole sweep, leaving one fused shift, or and test (shifted_all_ones) for each subset,
+ *  instead of two shift-ors and an all_ones.
+ */
+static inline void start_sweep(subset_sum_checker &checker, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const unsigned long long remaining) {
+    const unsigned int last = subset_size - 2;
+    const unsigned int M = subset[subset_size - 1];
+    const unsigned int length = checker.length;
+
+    if (changed_from < last) calculate_sums(checker.sums, checker.sums_live, length, subset, last, changed_from);
+
+#ifdef RUN_STATS
+    COUNT_STAT(sweeps, 1);
+    COUNT_STAT(dp_words, length);
+    for (unsigned int i = changed_from; i < last; i++) COUNT_STAT(dp_words, checker.sums_live[i]);
+#endif
+
+    unsigned int prefix_sum = 0;
+    for (unsigned int i = 0; i < last; i++) prefix_sum += subset[i];
+
+    bool prefix_complete;
+    unsigned int prefix_covered = contiguous_sums(subset, last, prefix_complete);
+
+    shift_or(checker.sweep_pattern, length, sums_at_depth(checker, last - 1), M);
+    or_single(checker.sweep_pattern, length, M - 1);
+
+    checker.sweep_count = M - subset[last];
+    if (checker.sweep_count > remaining) checker.sweep_count = remaining;
+    checker.sweep_position = 0;
+    checker.sweep_changed_from = changed_from;
+
+    for (unsigned int i = 0; i <= checker.sweep_count / 64; i++) checker.sweep_passed[i] = 0;
+
+    for (unsigned int i = 0; i < checker.sweep_count; i++) {
+        unsigned int x = subset[last] + i;
+        unsigned int max = sums_test_max(M, prefix_sum + x + M);
+        unsigned int covered = (prefix_complete && x <= prefix_covered + 1) ? prefix_covered + x : prefix_covered;
+
+        accept_filter filter = accept_subset(M, max, covered);
+        checker.accept_filter_counts[filter]++;
+#ifdef RUN_STATS
+        COUNT_STAT(sums_tests, filter == ACCEPT_NONE);
+#endif
+
+        if (filter != ACCEPT_NONE || shifted_all_ones(checker.sweep_pattern, length, x, M, max)) {
+            checker.sweep_passed[i / 64] |= ((uint64_t)1) << (i % 64);
+        }
+    }
+}
+
+/**
+ *  Returns the result for the next subset in the sweep, setting changed_from to the first element changed since the
+ *  last subset whose sums were calculated (for testing it again with the sums bitsets).
+ */
+static inline bool next_in_sweep(subset_sum_checker &checker, const unsigned int subset_size, unsigned int &changed_from) {
+    unsigned int position = checker.sweep_position++;
+    changed_from = (position == 0) ? checker.sweep_changed_from : subset_size - 2;
+
+    return (checker.sweep_passed[position / 64] >> (position % 64)) & 1;
+}
+#endif
+
+/**
+ *  Tests the next subset of a run, where remaining is how many subsets are left in the run (including this one).
+ *  last_element_sweep is the sweeps_last_element of the enumerator listing the subsets.
+ *
+ *  reporter_t decides what else is done with the subsets (the client prints, records and verifies them, see
+ *  tester_reporter, and check_subsets hands them to a subset_sink):
+ *
+ *      needs_report(success)                           true if a subset which passed (or failed) by one of the fast
+ *                                                      paths needs to be reported.
+ *      test(subset, subset_size, changed_from, rank)   tests a subset with the sums bitsets (see check_sums) and
+ *                                                      reports it if it needs to be, returning true if it passed.
+ *      report(subset, subset_size, changed_from, rank, success)
+ *                                                      reports a subset decided by a fast path.
+ */
+template <bool last_element_sweep, typename reporter_t>
+static inline bool check_next_subset(subset_sum_checker &checker, reporter_t &reporter, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank, const unsigned long long remaining) {
+#ifdef LAST_ELEMENT_SWEEP
+    if (last_element_sweep && subset_size >= 3) {
+        if (checker.sweep_position == checker.sweep_count) start_sweep(checker, subset, subset_size, changed_from, remaining);
+
+        unsigned int sweep_changed_from;
+        bool success = next_in_sweep(checker, subset_size, sweep_changed_from);
+        if (reporter.needs_report(success)) reporter.report(subset, subset_size, sweep_changed_from, rank, success);
+        return success;
+    }
+#endif
+
+    /**
+     *  Subsets accepted by a filter don't update the sums stack, so the next subset tested needs to recalculate it
+     *  from the first element changed since the last one that did (skipped_from).
+     */
+    unsigned int from = (changed_from < checker.skipped_from) ? changed_from : checker.skipped_from;
+
+    unsigned int M = subset[subset_size - 1];
+    unsigned int subset_sum = 0;
+    for (unsigned int i = 0; i < subset_size; i++) subset_sum += subset[i];
+
+    bool complete;
+    accept_filter filter = accept_subset(M, sums_test_max(M, subset_sum), contiguous_sums(subset, subset_size - 1, complete));
+    checker.accept_filter_counts[filter]++;
+
+    checker.skipped_from = subset_size;
+    if (filter == ACCEPT_NONE) return reporter.test(subset, subset_size, from, rank);
+
+    if (reporter.needs_report(true)) {
+        reporter.report(subset, subset_size, from, rank, true);
+    } else {
+        checker.skipped_from = from;
+    }
+    return true;
+}
+
+/**
+ *  check_subsets tests the subsets in a subset_range (count subsets from first_rank, in order), handing the ones that
+ *  fail (and with report_passed, the ones that pass) to a subset_sink.  The sums of a subset can be found with
+ *  calculate_sums if the sink needs them.
+ */
+struct subset_range {
+    subset_order order;
+    subset_rank_t first_rank;
+    unsigned long long count;
+};
+
+struct subset_counts {
+    unsigned long long pass;
+    unsigned long long fail;
+};
+
+struct subset_sink {
+    bool report_passed;
+
+    subset_sink() : report_passed(false) {
+    }
+
+    virtual ~subset_sink() {
+    }
+
+    virtual void tested_subset(const subset_rank_t rank, const unsigned int *subset, const unsigned int subset_size, const bool success) = 0;
+};
+
+struct sink_reporter {
+    subset_sum_checker &checker;
+    subset_sink &sink;
+
+    sink_reporter(subset_sum_checker &checker, subset_sink &sink) : checker(checker), sink(sink) {
+    }
+
+    bool needs_report(const bool success) const {
+        return !success || sink.report_passed;
+    }
+
+    bool test(const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank) {
+        bool success = check_sums(checker, subset, subset_size, changed_from);
+        if (needs_report(success)) sink.tested_subset(rank, subset, subset_size, success);
+        return success;
+    }
+
+    void report(const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank, const bool success) {
+        sink.tested_subset(rank, subset, subset_size, success);
+    }
+};
+
+template <typename enumerator_t>
+static subset_counts check_subsets_in_order(subset_sum_checker &checker, const subset_range &range, subset_sink &sink) {
+    const unsigned int subset_size = checker.subset_size;
+    subset_counts counts = { 0, 0 };
+    sink_reporter reporter(checker, sink);
+
+    enumerator_t enumerator(checker.max_set_value, subset_size);
+    enumerator.seek(range.first_rank);
+    if (enumerator.done()) return counts;
+
+    unsigned long long count = range.count;
+    if ((subset_rank_t)count > enumerator.total - range.first_rank) count = (unsigned long long)(enumerator.total - range.first_rank);
+
+#ifdef LAST_ELEMENT_SWEEP
+    checker.sweep_count = 0;
+    checker.sweep_position = 0;
+#endif
+    checker.skipped_from = subset_size;
+
+    for (unsigned long long i = 0; i < count; i++) {
+        if (check_next_subset<enumerator_t::sweeps_last_element>(checker, reporter, enumerator.subset, subset_size, enumerator.changed_from_position(), enumerator.rank, count - i)) counts.pass++;
+        else counts.fail++;
+
+        enumerator.next();
+    }
+    return counts;
+}
+
+inline subset_counts check_subsets(subset_sum_checker &checker, const subset_range &range, subset_sink &sink) {
+    switch (range.order) {
+        case JUN_LIU_ORDER:         return check_subsets_in_order<jun_liu_enumerator>(checker, range, sink);
+        case REVOLVING_DOOR_ORDER:  return check_subsets_in_order<revolving_door_enumerator>(checker, range, sink);
+        default:                    return check_subsets_in_order<lexicographic_enumerator>(checker, range, sink);
+    }
+}
+
+#endif
@@ -1,15 +1,49 @@
+/**
+ *  So the output (and its offsets in checkpoints) can grow past 2GB on 32 bit builds.
+ */
+#ifndef _WIN32
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include <cstdio>
+#include <cstdarg>
 #include <cstdlib>
 #include <cstring>
 #include <climits>
 #include <cmath>
+#include <stdint.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include <string>
+#include <new>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
+#if defined(ENABLE_THREADS) || defined(ENABLE_CHECKPOINTING)
+#include <pthread.h>
+#endif
+
+#ifdef ENABLE_CHECKPOINTING
+#include <errno.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "shift_or.hpp"
+#include "subset_ranks.hpp"
+#include "subset_output.hpp"
+#include "failed_set_records.hpp"
+#include "subset_sum_checker.hpp"
+
 /**
  *  Includes required for BOINC
  */
@@ -28,272 +62,395 @@
 
 using namespace std;
 
-const unsigned int ELEMENT_SIZE = sizeof(unsigned int) * 8;
-
+/**
+ *  The subsets are tested with a subset_sum_checker (see subset_sum_checker.hpp), with bitsets of max_sums_length
+ *  elements.  With -DVERIFY_WORD_WIDTH every subset is also calculated with the other word size (verify_word_t, in
+ *  verify_sums), and the program quits if the sums differ.
+ */
 unsigned long int max_sums_length;
-unsigned int *sums;
-unsigned int *new_sums;
+unsigned int max_sums_bits;
 
-string checkpoint_file = "sss_checkpoint.txt";
-string output_filename = "failed_sets.txt";
-FILE *output_target;
+#ifdef VERIFY_WORD_WIDTH
+unsigned long int verify_sums_length;
+#endif
 
-#ifdef HTML_OUTPUT
-double max_digits;
-double max_set_digits;
+/**
+ *  With -DVERIFY_HALF_RANGE every subset is also calculated over the full range (in full_sums, with full_sums_length
+ *  elements), and the program quits if the result or any of the sums differ.
+ */
+#if defined(FULL_RANGE_SUMS) && defined(VERIFY_HALF_RANGE)
+#error "VERIFY_HALF_RANGE cannot be used with FULL_RANGE_SUMS"
+#endif
+
+#ifdef VERIFY_HALF_RANGE
+unsigned long int full_sums_length;
 #endif
 
 /**
- *  Print the bits in an unsigned int.  Note this prints out from right to left (not left to right)
+ *  How many subsets each accept filter accepted is counted per checker, then added up in accept_filter_counts and
+ *  printed out at the end.  With -DVERIFY_ACCEPT_FILTER every subset is also tested with the sums bitsets, and the
+ *  program quits if they disagree.
  */
-void print_bits(const unsigned int number) {
-    unsigned int pos = 1 << (ELEMENT_SIZE - 1);
-    while (pos > 0) {
-        if (number & pos) fprintf(output_target, "1");
-        else fprintf(output_target, "0");
-        pos >>= 1;
-    }
-}
+unsigned long long accept_filter_counts[ACCEPT_FILTERS];
 
 /**
- * Print out an array of bits
+ *  With -DBINARY_OUTPUT the failed sets are written as binary records (see failed_set_records.hpp) instead of the text
+ *  report, which render_failed_sets can make from them.  The ranks in the records are from records_first_rank (the
+ *  first subset of the run).  Unless compiled with -DNO_MISSING_SUMS, the records also have the ranges of sums each
+ *  failed set is missing.
  */
-void print_bit_array(const unsigned int *bit_array, const unsigned int bit_array_length) {
-    for (unsigned int i = 0; i < bit_array_length; i++) {
-        print_bits(bit_array[i]);
-    }
-}
+#if defined(BINARY_OUTPUT) && defined(VERBOSE)
+#error "BINARY_OUTPUT cannot be used with VERBOSE"
+#endif
+
+#ifdef BINARY_OUTPUT
+subset_rank_t records_first_rank;
+#endif
 
 /**
- *  Print out all the elements in a subset
+ *  Sets the lengths of the sums bitsets (and the VERIFY_* ones) and how many bits of them are printed for subsets of
+ *  subset_size elements up to max_set_value, returning the sums kernel they will be tested with.
  */
-void print_subset(const unsigned int *subset, const unsigned int subset_size) {
-#ifndef HTML_OUTPUT
-    fprintf(output_target, "[");
-    for (unsigned int i = 0; i < subset_size; i++) {
-        fprintf(output_target, "%4u", subset[i]);
-    }
-    fprintf(output_target, "]");
-#else
-    fprintf(output_target, "[");
-    for (unsigned int i = 0; i < subset_size; i++) {
-        double whitespaces = (max_set_digits - floor(log10(subset[i]))) - 1;
+sums_test_function set_sums_lengths(const unsigned int max_set_value, const unsigned int subset_size) {
+    unsigned long int max_set_sum = 0;
+    for (unsigned int i = 0; i < subset_size; i++) max_set_sum += max_set_value - i;
 
-        for (int j = 0; j < whitespaces; j++) fprintf(output_target, "&nbsp;");
+    /**
+     *  Calculate the maximum set length (in bits) so we can use this for printing out the values cleanly.
+     */
+    max_sums_bits = ((max_set_sum / PRINT_ELEMENT_SIZE) + 1) * PRINT_ELEMENT_SIZE;
 
-        fprintf(output_target, "%u", subset[i]);
-    }
-    fprintf(output_target, "]");
+#ifdef VERIFY_WORD_WIDTH
+    /**
+     *  The same sums as the sums bitsets hold (see select_sums_kernel), in verify_word_t elements.
+     */
+#ifdef FULL_RANGE_SUMS
+    unsigned long int max_stored_sum = max_set_sum;
+#else
+    unsigned long int max_stored_sum = max_set_sum / 2;
+    if (max_stored_sum < max_set_value) max_stored_sum = max_set_value;
+#endif
+    verify_sums_length = (max_stored_sum / (sizeof(verify_word_t) * 8)) + 1;
+#endif
+
+#ifdef VERIFY_HALF_RANGE
+    full_sums_length = (max_set_sum / ELEMENT_SIZE) + 1;
 #endif
+
+    return select_sums_kernel(max_set_value, subset_size, max_sums_length);
 }
 
 /**
- * Print out an array of bits, coloring the required subsets green, if there is a missing sum (a 0) it is colored red
+ *  Everything needed to test, print and verify subsets, so each thread can have its own.  The subsets are tested by
+ *  checker, and the rest is what the client adds around it.
  */
-void print_bit_array_color(const unsigned int *bit_array, unsigned long int max_sums_length, unsigned int min, unsigned int max) {
-    unsigned int msl = max_sums_length * ELEMENT_SIZE;
-    unsigned int number, pos;
-    unsigned int count = 0;
+struct subset_tester {
+    subset_sum_checker checker;
+#ifdef SHOW_SUM_CALCULATION
+    sums_word_t *new_sums;
+#endif
+#ifdef VERIFY_WORD_WIDTH
+    verify_word_t *verify_sums;
+    unsigned int *verify_sums_live;
+#endif
+#ifdef VERIFY_HALF_RANGE
+    sums_word_t *full_sums;
+    unsigned int *full_sums_live;
+#endif
+#ifdef VERBOSE
+    char *sums_line;
+#endif
+#ifdef BINARY_OUTPUT
+    vector<missing_sums> missing;
+#endif
+    result_buffer results;
+};
+
+string checkpoint_file = "sss_checkpoint.txt";
+string output_filename = "failed_sets.txt";
+FILE *output_target;
 
-//    fprintf(output_target, " - MSL: %u, MIN: %u, MAX: %u - ", msl, min, max);
+/**
+ *  Syncs everything written to a file to disk, returning false if it couldn't be.
+ */
+static bool sync_file(FILE *file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
 
-    bool red_on = false;
+/**
+ *  How many bytes of the output were written (offset, or -1 if it isn't a file that can be read back) and their digest
+ *  (64 bit FNV-1a) at the last checkpoint.  The digest is brought up to date at each checkpoint by reading back what
+ *  was written since the one before.
+ */
+const uint64_t OUTPUT_DIGEST_START = 14695981039346656037ULL;
+const uint64_t OUTPUT_DIGEST_PRIME = 1099511628211ULL;
 
-//    fprintf(output_target, " msl - min [%u], msl - max [%u] ", (msl - min), (msl - max));
+struct output_position {
+    long long offset;
+    uint64_t digest;
+};
 
-    for (unsigned int i = 0; i < max_sums_length; i++) {
-        number = bit_array[i];
-        pos = 1 << (ELEMENT_SIZE - 1);
+output_position checkpointed_output = { 0, OUTPUT_DIGEST_START };
 
-        while (pos > 0) {
-            if ((msl - min) == count) {
-                red_on = true;
-#ifndef HTML_OUTPUT
-                fprintf(output_target, "\e[32m");
+#if defined(ENABLE_CHECKPOINTING) || defined(ENABLE_THREADS)
+/**
+ *  Where the output is up to, as a 64 bit offset (ftell is limited to 2GB on 32 bit and Windows builds).  Used for
+ *  the checkpoints, and for the chunks each thread writes to its temporary file.
+ */
+static long long output_tell(FILE *output) {
+#ifdef _WIN32
+    return _ftelli64(output);
 #else
-                fprintf(output_target, "<b><span class=\"courier_green\">");
+    return ftello(output);
 #endif
-            }
+}
 
-            if (number & pos) fprintf(output_target, "1");
-            else {
-                if (red_on) {
-#ifndef HTML_OUTPUT
-                    fprintf(output_target, "\e[31m0\e[32m");
+/**
+ *  Reads up to count bytes of output from offset (without moving where it is written to), returning how many were read
+ *  or -1 if it can't be read.
+ */
+static long read_output(FILE *output, char *buffer, const unsigned long count, const long long offset) {
+#ifdef _WIN32
+    int fd = _fileno(output);
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+    long bytes_read = _read(fd, buffer, count);
+    _lseeki64(fd, 0, SEEK_END);
+    return bytes_read;
 #else
-                    fprintf(output_target, "<span class=\"courier_red\">0</span>");
+    return pread(fileno(output), buffer, count, offset);
+#endif
+}
 #endif
-                } else {
-                    fprintf(output_target, "0");
-                }
-            }
 
-            if ((msl - max) == count) {
-#ifndef HTML_OUTPUT
-                fprintf(output_target, "\e[0m");
+#ifdef ENABLE_CHECKPOINTING
+/**
+ *  Cuts the output down to length bytes.
+ */
+static void truncate_output(FILE *output, const long long length) {
+#ifdef _WIN32
+    if (_chsize_s(_fileno(output), length) != 0) fprintf(stderr, "Could not truncate the output.\n");
 #else
-                fprintf(output_target, "</span></b>");
+    if (ftruncate(fileno(output), length) != 0) fprintf(stderr, "Could not truncate the output.\n");
 #endif
-                red_on = false;
-            }
-
-            pos >>= 1;
-            count++;
-        }
-    }
 }
 
 /**
- *  Shift all the bits in an array of to the left by shift. src is unchanged, and the result of the shift is put into dest.
- *  length is the number of elements in dest (and src) which should be the same for both
- *
- *  Performs:
- *      dest = src << shift
+ *  Adds the bytes from to to of the output to digest, returning false if they can't be read.
  */
-static inline void shift_left(unsigned int *dest, const unsigned int length, const unsigned int *src, const unsigned int shift) {
-    unsigned int full_element_shifts = shift / ELEMENT_SIZE;
-    unsigned int sub_shift = shift % ELEMENT_SIZE;
+static bool digest_output(FILE *output, long long from, const long long to, uint64_t &digest) {
+    char buffer[65536];
 
-    /**
-     *  Note that the shift may be more than the length of an unsigned int (ie over 32), this needs to be accounted for, so the element
-     *  we're shifting from may be ahead a few elements in the array.  When we do the shift, we can do this quickly by getting the target bits
-     *  shifted to the left and doing an or with a shift to the right.
-     *  ie (if our elements had 8 bits):
-     *      00011010 101111101
-     *  doing a shift of 5, we could update the first one to:
-     *     00010111         // src[i + (full_element_shifts = 0) + 1] >> ((ELEMENT_SIZE = 8) - (sub_shift = 5)) // shift right 3
-     *     |
-     *     01000000
-     *  which would be:
-     *     01010111
-     *  then the next would just be the second element shifted to the left by 5:
-     *     10100000
-     *   which results in:
-     *     01010111 10100000
-     *   which is the whole array shifted to the left by 5
-     */
-    for (unsigned int i = 0; i < (length - full_element_shifts) - 1; i++) {
-        dest[i] = src[i + full_element_shifts] << sub_shift | src[i + full_element_shifts + 1] >> (ELEMENT_SIZE - sub_shift);
+    while (from < to) {
+        unsigned long to_read = sizeof(buffer);
+        if ((long long)to_read > to - from) to_read = (unsigned long)(to - from);
+
+        long bytes_read = read_output(output, buffer, to_read, from);
+        if (bytes_read <= 0) return false;
+
+        for (long i = 0; i < bytes_read; i++) digest = (digest ^ (unsigned char)buffer[i]) * OUTPUT_DIGEST_PRIME;
+        from += bytes_read;
     }
-    dest[length - 1] = src[length - 1] << sub_shift;
+    return true;
 }
 
 /**
- *  updates dest to:
- *      dest != src
- *
- *  Where dest and src are two arrays with length elements
+ *  Syncs everything written to the output so far to disk, and moves position up to it.  If the output isn't a file
+ *  (or can't be read back), the offset is -1.
  */
-static inline void or_equal(unsigned int *dest, const unsigned int length, const unsigned int *src) {
-    for (unsigned int i = 0; i < length; i++) dest[i] |= src[i];
+static void sync_output(FILE *output, output_position &position) {
+    fflush(output);
+
+    long long offset = output_tell(output);
+    if (offset < 0 || position.offset < 0 || !digest_output(output, position.offset, offset, position.digest)) {
+        position.offset = -1;
+        return;
+    }
+
+    sync_file(output);
+    position.offset = offset;
 }
 
 /**
- *  Adds the single bit (for a new set element) into dest:
- *
- *  dest |= 1 << number
+ *  Cuts off anything written to the output after the checkpoint at position, returning false if the output before it
+ *  doesn't match the checkpoint (so the run needs to start over).  Outputs which can't be checked (as they aren't
+ *  files, or the checkpoint is from before the output was journaled) are left as they are.
  */
-static inline void or_single(unsigned int *dest, const unsigned int length, const unsigned int number) {
-    unsigned int pos = number / ELEMENT_SIZE;
-    unsigned int tmp = number % ELEMENT_SIZE;
+static bool restore_output(FILE *output, const output_position &position) {
+    checkpointed_output = position;
+    if (position.offset < 0) return true;
+
+    fflush(output);
+    fseek(output, 0, SEEK_END);
+    long long length = output_tell(output);
+
+    uint64_t digest = OUTPUT_DIGEST_START;
+    if (length < 0 || !digest_output(output, 0, (length < position.offset) ? length : position.offset, digest)) {
+        fprintf(stderr, "Could not read the output back, continuing it without checking it.\n");
+        checkpointed_output.offset = -1;
+        return true;
+    }
+
+    if (length < position.offset || digest != position.digest) {
+        checkpointed_output.offset = 0;
+        checkpointed_output.digest = OUTPUT_DIGEST_START;
+        truncate_output(output, 0);
+        fseek(output, 0, SEEK_SET);
+        return false;
+    }
 
-    dest[length - pos - 1] |= 1 << tmp;
+    if (length > position.offset) {
+        fprintf(stderr, "Cutting %lld bytes written after the checkpoint off the output.\n", length - position.offset);
+        truncate_output(output, position.offset);
+        fseek(output, 0, SEEK_END);
+    }
+    return true;
 }
+#endif
 
 /**
- *  Tests to see if all the bits are 1s between min and max
+ *  Allocates the printing and VERIFY_* bitsets of a tester, with the lengths set for the current M and N.
  */
-static inline bool all_ones(const unsigned int *subset, const unsigned int length, const unsigned int min, const unsigned int max) {
-    unsigned int min_pos = min / ELEMENT_SIZE;
-    unsigned int min_tmp = min % ELEMENT_SIZE;
-    unsigned int max_pos = max / ELEMENT_SIZE;
-    unsigned int max_tmp = max % ELEMENT_SIZE;
-
-    /*
-     * This will print out all the 1s that we're looking for.
+static void new_tester_bitsets(subset_tester &tester, const unsigned int subset_size) {
+#ifdef SHOW_SUM_CALCULATION
+    tester.new_sums = new sums_word_t[max_sums_length];
+#endif
+#ifdef VERIFY_WORD_WIDTH
+    tester.verify_sums = new verify_word_t[subset_size * verify_sums_length];
+    tester.verify_sums_live = new_live_lengths(subset_size, verify_sums_length);
+#endif
+#ifdef VERIFY_HALF_RANGE
+    tester.full_sums = new sums_word_t[subset_size * full_sums_length];
+    tester.full_sums_live = new_live_lengths(subset_size, full_sums_length);
+#endif
+#ifdef VERBOSE
+    tester.sums_line = new char[max_sums_bits];
+#endif
+}
 
-    if (min_pos < max_pos) {
-        if (max_tmp > 0) {
-            print_bits(UINT_MAX >> (ELEMENT_SIZE - max_tmp));
-        } else {
-            print_bits(0);
-        }
-        for (unsigned int i = min_pos + 1; i < max_pos - 1; i++) {
-            print_bits(UINT_MAX);
-        }
-        print_bits(UINT_MAX << (min_tmp - 1));
-    } else {
-        print_bits((UINT_MAX << (min_tmp - 1)) & (UINT_MAX >> (ELEMENT_SIZE - max_tmp)));
-    }
-    */
+static void delete_tester_bitsets(subset_tester &tester) {
+#ifdef SHOW_SUM_CALCULATION
+    delete [] tester.new_sums;
+#endif
+#ifdef VERIFY_WORD_WIDTH
+    delete [] tester.verify_sums;
+    delete [] tester.verify_sums_live;
+#endif
+#ifdef VERIFY_HALF_RANGE
+    delete [] tester.full_sums;
+    delete [] tester.full_sums_live;
+#endif
+#ifdef VERBOSE
+    delete [] tester.sums_line;
+#endif
+}
 
-    if (min_pos == max_pos) {
-        unsigned int against = (UINT_MAX >> (ELEMENT_SIZE - max_tmp)) & (UINT_MAX << (min_tmp - 1));
-        return against == (against & subset[length - max_pos - 1]);
-    } else {
-        unsigned int against = UINT_MAX << (min_tmp - 1);
-        if (against != (against & subset[length - min_pos - 1])) {
-            return false;
-        }
-//        fprintf(output_target, "min success\n");
+/**
+ *  Allocates the bitsets for a subset_tester, which prints to output.
+ */
+void new_subset_tester(subset_tester &tester, const unsigned int max_set_value, const unsigned int subset_size, FILE *output) {
+    new_subset_sum_checker(tester.checker, max_set_value, subset_size);
+    new_tester_bitsets(tester, subset_size);
+    new_result_buffer(tester.results, output);
+}
 
-        for (unsigned int i = (length - min_pos - 2); i > (length - max_pos); i--) {
-            if (UINT_MAX != (UINT_MAX & subset[i])) {
-                return false;
-            }
-        }
-//        fprintf(output_target, "mid success\n");
+/**
+ *  Sets a tester up for another M and N (see test_sweep), after set_sums_lengths has been called for them.  The
+ *  checker's bitsets and the result buffer are kept.  The printing and VERIFY_* bitsets are made again, as they are
+ *  only in verbose and debugging builds.
+ */
+void reset_subset_tester(subset_tester &tester, const unsigned int max_set_value, const unsigned int subset_size) {
+    reset_subset_sum_checker(tester.checker, max_set_value, subset_size);
+    delete_tester_bitsets(tester);
+    new_tester_bitsets(tester, subset_size);
+}
 
-        if (max_tmp > 0) {
-            against = UINT_MAX >> (ELEMENT_SIZE - max_tmp);
-            if (against != (against & subset[length - max_pos - 1])) {
-                return false;
-            }
-        }
-//        fprintf(output_target, "max success\n");
+/**
+ *  Frees a subset_tester, adding its counts to accept_filter_counts (and its thread's to run_stats) and writing out
+ *  what's left in its result buffer.
+ */
+void delete_subset_tester(subset_tester &tester) {
+    for (unsigned int i = 0; i < ACCEPT_FILTERS; i++) accept_filter_counts[i] += tester.checker.accept_filter_counts[i];
+
+    delete_subset_sum_checker(tester.checker);
+    delete_tester_bitsets(tester);
+    delete_result_buffer(tester.results);
+#ifdef RUN_STATS
+    add_thread_stats();
+#endif
+}
 
+#if defined(VERIFY_WORD_WIDTH) || defined(VERIFY_HALF_RANGE)
+/**
+ *  Returns true if the sums 1 to subset_sum in two bitsets (of possibly different word sizes and lengths) are the same.
+ */
+template <typename word_t, typename other_word_t>
+static bool same_sums(const word_t *sums, const unsigned int length, const other_word_t *other_sums, const unsigned int other_length, const unsigned int subset_sum) {
+    for (unsigned int sum = 1; sum <= subset_sum; sum++) {
+        if (has_sum(sums, length, subset_sum, sum) != has_sum(other_sums, other_length, subset_sum, sum)) return false;
     }
-
     return true;
 }
+#endif
 
 /**
- *  Tests to see if a subset all passes the subset sum hypothesis
+ *  Tests to see if a subset all passes the subset sum hypothesis (see check_sums), printing, recording and verifying it.
+ *  rank is the position of the subset in the full list of subsets, which is printed out with it.
  */
-static inline bool test_subset(const unsigned int *subset, const unsigned int subset_size, const unsigned long long iteration, const unsigned int starting_subset, const bool doing_slice) {
-    //this is also symmetric.  TODO: Only need to check from the largest element in the set (9) to the sum(S)/2 == (13), need to see if everything between 9 and 13 is a 1
+static inline bool test_subset(subset_tester &tester, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank) {
+    bool success = check_sums(tester.checker, subset, subset_size, changed_from);
+
+#if defined(BINARY_OUTPUT) || defined(VERIFY_WORD_WIDTH) || defined(VERIFY_HALF_RANGE)
     unsigned int M = subset[subset_size - 1];
+#endif
+#if defined(VERBOSE) || defined(BINARY_OUTPUT) || defined(VERIFY_WORD_WIDTH) || defined(VERIFY_HALF_RANGE)
     unsigned int max_subset_sum = 0;
-
     for (unsigned int i = 0; i < subset_size; i++) max_subset_sum += subset[i];
-    
-    for (unsigned int i = 0; i < max_sums_length; i++) {
-        sums[i] = 0;
-        new_sums[i] = 0;
-    }
+#endif
 
-//    fprintf(output_target, "\n");
-    unsigned int current;
-    for (unsigned int i = 0; i < subset_size; i++) {
-        current = subset[i];
+#if defined(VERIFY_WORD_WIDTH) || defined(VERIFY_HALF_RANGE)
+    char rank_string[RANK_STRING_LENGTH];
+#endif
 
-        shift_left(new_sums, max_sums_length, sums, current);                    // new_sums = sums << current;
-//        fprintf(output_target, "new_sums = sums << %2u    = ", current);
-//        print_bit_array(new_sums, sums_length);
-//        fprintf(output_target, "\n");
+#if defined(VERBOSE) || (defined(BINARY_OUTPUT) && !defined(NO_MISSING_SUMS)) || defined(VERIFY_WORD_WIDTH) || defined(VERIFY_HALF_RANGE)
+    unsigned int final_length;
+    const sums_word_t *final_sums = live_sums(sums_at_depth(tester.checker, subset_size - 1), max_sums_length, max_subset_sum, final_length);
+#endif
 
-        or_equal(sums, max_sums_length, new_sums);                               //sums |= new_sums;
-//        fprintf(output_target, "sums |= new_sums         = ");
-//        print_bit_array(sums, sums_length);
-//        fprintf(output_target, "\n");
+#ifdef VERIFY_WORD_WIDTH
+    calculate_sums(tester.verify_sums, tester.verify_sums_live, verify_sums_length, subset, subset_size, changed_from);
 
-        or_single(sums, max_sums_length, current - 1);                           //sums |= 1 << (current - 1);
-//        fprintf(output_target, "sums != 1 << current - 1 = ");
-//        print_bit_array(sums, sums_length);
-//        fprintf(output_target, "\n");
+    unsigned int verify_final_length;
+    const verify_word_t *verify_final_sums = live_sums(tester.verify_sums + ((subset_size - 1) * verify_sums_length), verify_sums_length, max_subset_sum, verify_final_length);
+    bool sums_match = (success == all_ones(verify_final_sums, verify_final_length, M, sums_test_max(M, max_subset_sum)));
+    if (!same_sums(final_sums, final_length, verify_final_sums, verify_final_length, max_subset_sum)) sums_match = false;
+
+    if (!sums_match) {
+        fprintf(stderr, "ERROR: the %u and %u bit sums do not match on subset %s.\n", (unsigned int)(sizeof(sums_word_t) * 8), (unsigned int)(sizeof(verify_word_t) * 8), rank_to_string(rank, rank_string));
+        exit(1);
+    }
+#endif
+
+#ifdef VERIFY_HALF_RANGE
+    calculate_sums(tester.full_sums, tester.full_sums_live, full_sums_length, subset, subset_size, changed_from);
+
+    unsigned int full_final_length;
+    const sums_word_t *full_final_sums = live_sums(tester.full_sums + ((subset_size - 1) * full_sums_length), full_sums_length, max_subset_sum, full_final_length);
+    bool range_match = (success == all_ones(full_final_sums, full_final_length, M, max_subset_sum - M));
+
+    for (unsigned int sum = 1; sum <= max_subset_sum; sum++) {
+        if (has_sum(final_sums, final_length, max_subset_sum, sum) != get_bit(full_final_sums, full_final_length, sum - 1)) range_match = false;
     }
 
-    bool success = all_ones(sums, max_sums_length, M, max_subset_sum - M);
+    if (!range_match) {
+        fprintf(stderr, "ERROR: the half and full range sums do not match on subset %s.\n", rank_to_string(rank, rank_string));
+        exit(1);
+    }
+#endif
 
 #ifdef VERBOSE
 #ifdef FALSE_ONLY
@@ -301,192 +458,118 @@ static inline bool test_subset(const unsigned int *subset, const unsigned int su
 #endif
 
 #ifdef SHOW_SUM_CALCULATION
-        for (unsigned int i = 0; i < max_sums_length; i++) {
-            sums[i] = 0;
-            new_sums[i] = 0;
-        }
-
-        fprintf(output_target, "\n");
+        unsigned int current;
+        unsigned int partial_sum = 0;
+        unsigned int live, live_start;
+        append_char(tester.results, '\n');
         for (unsigned int i = 0; i < subset_size; i++) {
             current = subset[i];
-
-            shift_left(new_sums, max_sums_length, sums, current);                    // new_sums = sums << current;
-            fprintf(output_target, "new_sums = sums << %2u                                          = ", current);
-            print_bit_array(new_sums, max_sums_length);
-            fprintf(output_target, "\n");
-
-            or_equal(sums, max_sums_length, new_sums);                               //sums |= new_sums;
-            fprintf(output_target, "sums |= new_sums                                               = ");
-            print_bit_array(sums, max_sums_length);
-            fprintf(output_target, "\n");
-
-            or_single(sums, max_sums_length, current - 1);                           //sums |= 1 << (current - 1);
-            fprintf(output_target, "sums != 1 << current - 1                                       = ");
-            print_bit_array(sums, max_sums_length);
-            fprintf(output_target, "\n");
+            partial_sum += current;
+            live = live_length<sums_word_t>(max_sums_length, partial_sum);
+            live_start = max_sums_length - live;
+
+            for (unsigned int j = 0; j < max_sums_length; j++) tester.new_sums[j] = 0;
+            if (i > 0) shift_left(tester.new_sums + live_start, live, sums_at_depth(tester.checker, i - 1) + live_start, current);   // new_sums = sums << current;
+            append_printf(tester.results, "new_sums = sums << %2u                                          = ", current);
+            print_bit_array(tester.results, tester.sums_line, tester.new_sums, max_sums_length, max_sums_bits);
+            append_char(tester.results, '\n');
+
+            if (i > 0) or_equal(tester.new_sums + live_start, live, sums_at_depth(tester.checker, i - 1) + live_start);            //sums |= new_sums;
+            append_string(tester.results, "sums |= new_sums                                               = ");
+            print_bit_array(tester.results, tester.sums_line, tester.new_sums, max_sums_length, max_sums_bits);
+            append_char(tester.results, '\n');
+
+            append_string(tester.results, "sums != 1 << current - 1                                       = ");
+            print_sums(tester.results, tester.sums_line, sums_at_depth(tester.checker, i) + live_start, live, partial_sum, max_sums_bits);
+            append_char(tester.results, '\n');
         }
 #endif
 
-#ifdef HTML_OUTPUT
-        double whitespaces;
-        if (iteration == 0) whitespaces = (max_digits - 1);
-        else {
-            if (doing_slice)    whitespaces = (max_digits - floor(log10(iteration + starting_subset))) - 1;
-            else                whitespaces = (max_digits - floor(log10(iteration))) - 1;
-        }
-
-        for (int i = 0; i < whitespaces; i++) fprintf(output_target, "&nbsp;");
-#endif
-
-#ifndef HTML_OUTPUT
-        if (doing_slice)    fprintf(output_target, "%15llu ", (iteration + starting_subset));
-        else                fprintf(output_target, "%15llu ", iteration);
-#else
-        if (doing_slice)    fprintf(output_target, "%llu ", (iteration + starting_subset));
-        else                fprintf(output_target, "%llu ", iteration);
+        print_tested_subset(tester.results, tester.sums_line, rank, subset, subset_size, final_sums, final_length, max_subset_sum, max_sums_bits, success);
+#ifdef FALSE_ONLY
+    }
 #endif
-        print_subset(subset, subset_size);
-        fprintf(output_target, " = ");
-
-        unsigned int min = max_subset_sum - M;
-        unsigned int max = M;
-#ifdef ENABLE_COLOR
-        print_bit_array_color(sums, max_sums_length, min, max);
-#else 
-        print_bit_array(sums, max_sums_length);
 #endif
 
-        fprintf(output_target, "  match %4u to %4u ", min, max);
-#ifndef HTML_OUTPUT
-#ifdef ENABLE_COLOR
-        if (success)    fprintf(output_target, " = \e[32mpass\e[0m\n");
-        else            fprintf(output_target, " = \e[31mfail\e[0m\n");
-#else
-        if (success)    fprintf(output_target, " = pass\n");
-        else            fprintf(output_target, " = fail\n");
-#endif
+#ifdef BINARY_OUTPUT
+    if (!success) {
+#ifdef NO_MISSING_SUMS
+        append_failed_set(tester.results, rank - records_first_rank, M, NULL);
 #else
-        if (success)    fprintf(output_target, " = <span class=\"courier_green\">pass</span><br>\n");
-        else            fprintf(output_target, " = <span class=\"courier_red\">fail</span><br>\n");
+        find_missing_sums(final_sums, final_length, max_subset_sum, M, sums_test_max(M, max_subset_sum), tester.missing);
+        append_failed_set(tester.results, rank - records_first_rank, M, &tester.missing);
 #endif
-
-        fflush(output_target);
-
-#ifdef FALSE_ONLY
     }
-#endif
 #endif
 
     return success;
 }
 
 /**
- *  This only works up 68 choose 34.  After that we need to use a big number library
+ *  Returns true if a subset which passed (or failed) by one of the fast paths needs to go through test_subset anyway,
+ *  to be printed, recorded (with -DBINARY_OUTPUT) or verified.
  */
-static inline unsigned long long n_choose_k(unsigned int n, unsigned int k) {
-    unsigned int numerator = n - (k - 1);
-    unsigned int denominator = 1;
-
-    unsigned long long combinations = 1;
-
-    while (numerator <= n) {
-        combinations *= numerator;
-        combinations /= denominator;
-
-        numerator++;
-        denominator++;
-    }
-
-    return combinations;
+static inline bool needs_test_subset(const bool success) {
+#if defined(VERIFY_WORD_WIDTH) || defined(VERIFY_HALF_RANGE) || defined(VERIFY_ACCEPT_FILTER) || (defined(VERBOSE) && !defined(FALSE_ONLY))
+    return true;
+#elif defined(VERBOSE) || defined(BINARY_OUTPUT)
+    return !success;
+#else
+    return false;
+#endif
 }
 
-static inline void generate_ith_subset(unsigned long long i, unsigned int *subset, unsigned int subset_size, unsigned int max_set_value) {
-    unsigned int pos = 0;
-    unsigned int current_value = 1;
-    unsigned long long nck;
-
-    while (pos < subset_size - 1) {
-        nck = n_choose_k((max_set_value - 1) - current_value, (subset_size - 1) - (pos + 1));       //TODO: this does not need to be recalcualted, there is a faster way to do this
-
-        if (i < nck) {
-            subset[pos] = current_value;
-            pos++;
-        } else {
-            i -= nck;
-        }
-        current_value++;
+/**
+ *  Runs a subset through test_subset after a fast path decided it, quitting if they don't agree.
+ */
+static inline void retest_subset(subset_tester &tester, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank, const bool success) {
+    if (test_subset(tester, subset, subset_size, changed_from, rank) != success) {
+        char rank_string[RANK_STRING_LENGTH];
+        fprintf(stderr, "ERROR: the fast path and test_subset do not match on subset %s.\n", rank_to_string(rank, rank_string));
+        exit(1);
     }
-
-    subset[subset_size - 1] = max_set_value;
 }
 
-static inline void generate_next_subset_td(unsigned int *subset, unsigned int subset_size, unsigned int max_set_value) {
-    unsigned int current = subset_size - 2;
-    subset[current]++;
-
-//    fprintf(output_target, "subset_size: %u, max_set_value: %u\n", subset_size, max_set_value);
-
-//    print_subset(subset, subset_size);
-//    fprintf(output_target, "\n");
-
-    while (current > 0 && subset[current] > (max_set_value - (subset_size - (current + 1)))) {
-        subset[current - 1]++;
-        current--;
+/**
+ *  Hands the subsets decided by check_next_subset to the tester, for printing, recording and verifying.
+ */
+struct tester_reporter {
+    subset_tester &tester;
 
-//        print_subset(subset, subset_size);
-//        fprintf(output_target, "\n");
+    tester_reporter(subset_tester &tester) : tester(tester) {
     }
 
-    while (current < subset_size - 2) {
-        subset[current + 1] = subset[current] + 1;
-        current++;
-
-//        print_subset(subset, subset_size);
-//        fprintf(output_target, "\n");
+    bool needs_report(const bool success) const {
+        return needs_test_subset(success);
     }
 
-    subset[subset_size - 1] = max_set_value;
+    bool test(const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank) {
+        return test_subset(tester, subset, subset_size, changed_from, rank);
+    }
 
-//    print_subset(subset, subset_size);
-//    fprintf(output_target, "\n");
-}
+    void report(const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank, const bool success) {
+        retest_subset(tester, subset, subset_size, changed_from, rank, success);
+    }
+};
 
 /**
- * Jun: changes start
- * This algorithm keeps track of the bubbles between two adjacent elements in a subset.
- * Notion: N = subset_size; M = max_set_value;
- * The subset has (N+2) elements with subset[0] is fixed to be 1, subset[N+1] is fixed to be M, and subset[1] through subset[N] vary in the process.
- * There are (N+1) bubbles between pairs of adjacent elements.
- * Initially, the bubbles are initialized with bubbles[0] = M-N, and bubbles[1]=...=bubbles[N]=0.
- * Bubbles are gradually squeezed from left to right.
- * The process ends when bubbles[0]=...=bubbles[N-1]=0, and bubbles[N]=M-N.
+ *  Tests the next subset of a run, where remaining is how many subsets are left in the run (including this one).
+ *  last_element_sweep is the sweeps_last_element of the enumerator listing the subsets.
  */
-static inline void generate_next_subset_jl(unsigned int *subset, unsigned int subset_size, unsigned int max_set_value, unsigned int *bubbles) {
-    unsigned int index = subset_size - 1;
-    
-    // Update the new sizes for the bubbles
-    while (bubbles[index] == 0) {
-        index--;
-    }
-    
-    if (index < subset_size-1) {
-        bubbles[index]--;
-        bubbles[index+1]++;
-        bubbles[subset_size-1] += bubbles[subset_size];
-        bubbles[subset_size] = 0;
-    } else { // this means that (index == subset_size-1)
-        bubbles[index]--;
-        bubbles[subset_size]++;
-    }
-    
-    // write the subset under new bubbles
-    subset[0] = 1;
-    for (index = 1; index <= subset_size; index++) {
-        subset[index] = subset[index-1] + bubbles[index];
-    }
+template <bool last_element_sweep>
+static inline bool test_next_subset(subset_tester &tester, const unsigned int *subset, const unsigned int subset_size, const unsigned int changed_from, const subset_rank_t rank, const unsigned long long remaining) {
+    tester_reporter reporter(tester);
+    return check_next_subset<last_element_sweep>(tester.checker, reporter, subset, subset_size, changed_from, rank, remaining);
 }
 
-void write_checkpoint(string filename, const unsigned long long iteration, const unsigned long long pass, const unsigned long long fail) {
+/**
+ *  Checkpoints are written to a temporary file, which is synced and renamed over the last checkpoint, so there is
+ *  always a whole checkpoint to start from.  As well as how far the run got, they hold how many bytes of output had
+ *  been written (synced to disk before the checkpoint) and a digest of them (see output_position).  Anything written
+ *  after the last checkpoint is cut off the output when starting from it (see restore_output), so the output can't end
+ *  up with duplicates or half a line, and failed sets don't need a checkpoint of their own.
+ */
+void write_checkpoint(string filename, const unsigned long long iteration, const unsigned long long pass, const unsigned long long fail, const output_position &output) {
 #ifdef _BOINC_
     string output_path;
     int retval = boinc_resolve_filename_s(filename.c_str(), output_path);
@@ -494,24 +577,45 @@ void write_checkpoint(string filename, const unsigned long long iteration, const
         fprintf(stderr, "APP: error writing checkpoint (resolving checkpoint file name)\n");
         return;
     }   
-
-    ofstream checkpoint_file(output_path.c_str());
 #else
-    ofstream checkpoint_file(filename.c_str());
+    string output_path = filename;
 #endif
-    if (!checkpoint_file.is_open()) {
+    string temp_path = output_path + ".tmp";
+
+    FILE *checkpoint_file = fopen(temp_path.c_str(), "w");
+    if (checkpoint_file == NULL) {
         fprintf(stderr, "APP: error writing checkpoint (opening checkpoint file)\n");
         return;
     }   
 
-    checkpoint_file << "iteration: " << iteration << endl;
-    checkpoint_file << "pass: " << pass << endl;
-    checkpoint_file << "fail: " << fail << endl;
+    fprintf(checkpoint_file, "iteration: %llu\n", iteration);
+    fprintf(checkpoint_file, "pass: %llu\n", pass);
+    fprintf(checkpoint_file, "fail: %llu\n", fail);
+    fprintf(checkpoint_file, "output_offset: %lld\n", output.offset);
+    fprintf(checkpoint_file, "output_digest: %016llx\n", (unsigned long long)output.digest);
+
+    bool written = sync_file(checkpoint_file);
+    if (fclose(checkpoint_file) != 0) written = false;
+
+    if (!written) {
+        fprintf(stderr, "APP: error writing checkpoint (writing checkpoint file)\n");
+        remove(temp_path.c_str());
+        return;
+    }
 
-    checkpoint_file.close();
+#ifdef _BOINC_
+    retval = boinc_rename(temp_path.c_str(), output_path.c_str());
+#else
+    int retval = rename(temp_path.c_str(), output_path.c_str());
+#endif
+    if (retval) fprintf(stderr, "APP: error writing checkpoint (renaming checkpoint file)\n");
 }
 
-bool read_checkpoint(string sites_filename, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail) {
+/**
+ *  Reads a checkpoint, returning false if there isn't one.  Checkpoints from before the output was journaled have an
+ *  output offset of -1.
+ */
+bool read_checkpoint(string sites_filename, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail, output_position &output) {
 #ifdef _BOINC_
     string input_path;
     int retval = boinc_resolve_filename_s(sites_filename.c_str(), input_path);
@@ -544,41 +648,1390 @@ bool read_checkpoint(string sites_filename, unsigned long long &iteration, unsig
         exit(0);
     }
 
+    output.offset = -1;
+    output.digest = OUTPUT_DIGEST_START;
+
+    if (!(sites_file >> s)) return true;
+    sites_file >> output.offset;
+    if (s.compare("output_offset:") != 0 || sites_file.fail()) {
+        fprintf(stderr, "ERROR: malformed checkpoint! could not read 'output_offset'\n");
+        exit(0);
+    }
+
+    unsigned long long digest;
+    sites_file >> s >> hex >> digest >> dec;
+    if (s.compare("output_digest:") != 0 || sites_file.fail()) {
+        fprintf(stderr, "ERROR: malformed checkpoint! could not read 'output_digest'\n");
+        exit(0);
+    }
+    output.digest = digest;
+
     return true;
 }
 
+static double wall_time() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + (now.tv_usec / 1e6);
+}
 
-int main(int argc, char** argv) {
-#ifdef _BOINC_
-    int retval = 0;
-#ifdef BOINC_APP_GRAPHICS
-#if defined(_WIN32) || defined(__APPLE)
-    retval = boinc_init_graphics(worker);
-#else
-    retval = boinc_init_graphics(worker, argv[0]);
-#endif
-#else
-    retval = boinc_init();
-#endif
-    if (retval) exit(retval);
-#endif
+#ifdef ENABLE_CHECKPOINTING
+/**
+ *  Progress is reported and checkpoints are made every progress_interval and checkpoint_interval seconds (set with
+ *  --progress-interval and --checkpoint-interval), rather than every so many subsets, as how long those take depends
+ *  on the host.  A timer thread (run_progress_timer) sets the PROGRESS_DUE and CHECKPOINT_DUE bits of progress_flags,
+ *  so the testing loops only do a relaxed load of it for each subset (progress_due), and take the flags when one is
+ *  set.  With BOINC, checkpoints also wait for boinc_time_to_checkpoint, so the user's preference is kept (see
+ *  take_checkpoint_due).
+ */
+const unsigned int PROGRESS_DUE = 1;
+const unsigned int CHECKPOINT_DUE = 2;
+
+double progress_interval = 1.0;
+double checkpoint_interval = 10.0;
+
+/**
+ *  In daemon mode, checkpoints are reported after the output of the job (see serve_jobs) instead of written to a file.
+ */
+bool report_checkpoints = false;
+
+volatile unsigned int progress_flags = 0;
+
+pthread_t progress_timer;
+pthread_mutex_t progress_timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t progress_timer_wake = PTHREAD_COND_INITIALIZER;
+bool progress_timer_stop = false;
+
+/**
+ *  Older compilers (eg the gcc 4.0 used for OS X i686) don't have the __atomic builtins, where an aligned volatile
+ *  load and a mutex for the updates do the same job.
+ */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define ATOMIC_PROGRESS_FLAGS
+#endif
+
+static inline bool progress_due() {
+#ifdef ATOMIC_PROGRESS_FLAGS
+    return __builtin_expect(__atomic_load_n(&progress_flags, __ATOMIC_RELAXED) != 0, 0);
+#else
+    return progress_flags != 0;
+#endif
+}
+
+/**
+ *  Returns the flags which are set, and clears them.
+ */
+static unsigned int take_progress_flags() {
+#ifdef ATOMIC_PROGRESS_FLAGS
+    return __atomic_exchange_n(&progress_flags, 0, __ATOMIC_ACQ_REL);
+#else
+    pthread_mutex_lock(&progress_timer_mutex);
+    unsigned int flags = progress_flags;
+    progress_flags = 0;
+    pthread_mutex_unlock(&progress_timer_mutex);
+    return flags;
+#endif
+}
+
+/**
+ *  progress_timer_mutex must be held.
+ */
+static void set_progress_flags(const unsigned int flags) {
+#ifdef ATOMIC_PROGRESS_FLAGS
+    __atomic_fetch_or(&progress_flags, flags, __ATOMIC_RELEASE);
+#else
+    progress_flags |= flags;
+#endif
+}
+
+/**
+ *  Takes the flags which are set, returning whether a checkpoint should be made.  With BOINC, a checkpoint which
+ *  boinc_time_to_checkpoint turns down is left due, so it is tried again at the next poll (rather than waiting for the
+ *  next checkpoint_interval), and CHECKPOINT_DUE is only cleared for good when the checkpoint is written.
+ */
+static bool take_checkpoint_due() {
+    bool checkpoint = (take_progress_flags() & CHECKPOINT_DUE) != 0;
+#ifdef _BOINC_
+    if (checkpoint && !report_checkpoints && !boinc_time_to_checkpoint()) {
+        pthread_mutex_lock(&progress_timer_mutex);
+        set_progress_flags(CHECKPOINT_DUE);
+        pthread_mutex_unlock(&progress_timer_mutex);
+        checkpoint = false;
+    }
+#endif
+    return checkpoint;
+}
+
+static void* run_progress_timer(void *arguments) {
+    double last_checkpoint = wall_time();
+
+    pthread_mutex_lock(&progress_timer_mutex);
+    while (!progress_timer_stop) {
+        double wake_time = wall_time() + progress_interval;
+
+        struct timespec wake;
+        wake.tv_sec = (time_t)wake_time;
+        wake.tv_nsec = (long)((wake_time - wake.tv_sec) * 1e9);
+
+        while (!progress_timer_stop && pthread_cond_timedwait(&progress_timer_wake, &progress_timer_mutex, &wake) != ETIMEDOUT);
+        if (progress_timer_stop) break;
+
+        unsigned int flags = PROGRESS_DUE;
+        double now = wall_time();
+        if (now - last_checkpoint >= checkpoint_interval) {
+            flags |= CHECKPOINT_DUE;
+            last_checkpoint = now;
+        }
+        set_progress_flags(flags);
+    }
+    pthread_mutex_unlock(&progress_timer_mutex);
+
+    return NULL;
+}
+
+void start_progress_timer() {
+    progress_timer_stop = false;
+    if (pthread_create(&progress_timer, NULL, run_progress_timer, NULL) != 0) {
+        fprintf(stderr, "ERROR: could not start the progress timer.\n");
+        exit(1);
+    }
+}
+
+void stop_progress_timer() {
+    pthread_mutex_lock(&progress_timer_mutex);
+    progress_timer_stop = true;
+    pthread_cond_signal(&progress_timer_wake);
+    pthread_mutex_unlock(&progress_timer_mutex);
+
+    pthread_join(progress_timer, NULL);
+}
+
+/**
+ *  Reports how far through the subsets to test we are, and writes a checkpoint if checkpoint is true.
+ */
+static inline void update_progress(const unsigned long long iteration, const unsigned long long subsets_in_run, const unsigned long long pass, const unsigned long long fail, const bool checkpoint) {
+#ifdef _BOINC_
+    boinc_fraction_done((double)iteration / (double)subsets_in_run);
+#endif
+//    printf("\r%lf", (double)iteration / (double)subsets_in_run);
+
+    if (checkpoint && report_checkpoints) {
+        fprintf(output_target, "checkpoint %llu %llu %llu\n", iteration, pass, fail);
+        fflush(output_target);
+        return;
+    }
+
+    if (checkpoint) {
+//        fprintf(stderr, "\n*****Checkpointing! *****\n");
+#ifdef RUN_STATS
+        double start = stats_time();
+#endif
+        sync_output(output_target, checkpointed_output);
+        write_checkpoint(checkpoint_file, iteration, pass, fail, checkpointed_output);
+#ifdef RUN_STATS
+        COUNT_STAT(checkpoints, 1);
+        COUNT_STAT(checkpoint_seconds, stats_time() - start);
+#endif
+#ifdef _BOINC_
+        boinc_checkpoint_completed();
+#endif
+    }
+}
+#endif
+
+/**
+ *  Tests the subsets ranked first_rank + iteration to first_rank + subsets_in_run - 1 in the order listed by
+ *  enumerator_t, with tester (set up for max_set_value and subset_size).  The enumerator is a local of its actual type,
+ *  so its calls aren't virtual.
+ */
+template <typename enumerator_t>
+static void test_subsets_in_order(subset_tester &tester, const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail) {
+    enumerator_t enumerator(max_set_value, subset_size);
+    enumerator.seek(first_rank + iteration);
+
+    bool success;
+
+    while (iteration < subsets_in_run) {
+#ifdef RUN_STATS
+        stats_sample sample;
+        start_stats_sample(sample);
+#endif
+        success = test_next_subset<enumerator_t::sweeps_last_element>(tester, enumerator.subset, subset_size, enumerator.changed_from_position(), enumerator.rank, subsets_in_run - iteration);
+#ifdef RUN_STATS
+        lap_stats_sample(sample, shared_stats::thread_stats.testing_seconds);
+#endif
+
+        if (success)    pass++;
+        else            fail++;
+
+        enumerator.next();
+        iteration++;
+#ifdef RUN_STATS
+        lap_stats_sample(sample, shared_stats::thread_stats.enumeration_seconds);
+        end_stats_sample(sample);
+#endif
+
+#ifdef ENABLE_CHECKPOINTING
+        /**
+         *  The result buffer is written out before a checkpoint, so the checkpoint covers the failed sets found before it.
+         */
+        if (progress_due()) {
+            bool checkpoint = take_checkpoint_due();
+            if (checkpoint) flush_results(tester.results);
+            update_progress(iteration, subsets_in_run, pass, fail, checkpoint);
+        }
+#endif
+    }
+}
+
+void test_subsets(subset_tester &tester, const subset_order order, const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail) {
+    switch (order) {
+        case JUN_LIU_ORDER:         test_subsets_in_order<jun_liu_enumerator>(tester, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail); break;
+        default:                    test_subsets_in_order<lexicographic_enumerator>(tester, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail); break;
+    }
+}
+
+/**
+ *  How many ways each sum 0 ... length - 1 can be made from the free elements of a subset (total is their sum).  Unlike
+ *  a sums bitset, an element can be taken out again (see remove_sum_count), so moving to the next subset in revolving
+ *  door order is one removal and one insertion instead of recalculating the sums.  The counts are 32 bit, which is
+ *  exact for up to 31 free elements.
+ */
+const unsigned int MAX_COUNTED_ELEMENTS = 31;
+
+struct sum_counts {
+    uint32_t *counts;
+    unsigned int length;
+    unsigned int total;
+};
+
+void new_sum_counts(sum_counts &sc, const unsigned int length) {
+    sc.counts = new uint32_t[length];
+    sc.length = length;
+    sc.total = 0;
+
+    memset(sc.counts, 0, length * sizeof(uint32_t));
+    sc.counts[0] = 1;
+}
+
+void delete_sum_counts(sum_counts &sc) {
+    delete [] sc.counts;
+}
+
+/**
+ *  Only the counts up to the sum of the elements (after adding, or before removing) can change.
+ */
+static inline void add_sum_count(sum_counts &sc, const unsigned int element) {
+    sc.total += element;
+    unsigned int top = (sc.total < sc.length) ? sc.total : sc.length - 1;
+
+    for (unsigned int s = top; s >= element; s--) sc.counts[s] += sc.counts[s - element];
+    COUNT_STAT(dp_words, (top >= element) ? top - element + 1 : 0);
+}
+
+static inline void remove_sum_count(sum_counts &sc, const unsigned int element) {
+    unsigned int top = (sc.total < sc.length) ? sc.total : sc.length - 1;
+    sc.total -= element;
+
+    for (unsigned int s = element; s <= top; s++) sc.counts[s] -= sc.counts[s - element];
+    COUNT_STAT(dp_words, (top >= element) ? top - element + 1 : 0);
+}
+
+/**
+ *  Tests if every sum M to max can be made from the free elements (counted in sc) and M.
+ */
+static inline bool counts_all_ones(const sum_counts &sc, const unsigned int M, const unsigned int max) {
+    for (unsigned int s = M; s <= max; s++) {
+        if (sc.counts[s] == 0 && sc.counts[s - M] == 0) {
+            COUNT_STAT(dp_words, 2 * (s - M + 1));
+            COUNT_STAT(early_exits, s < max);
+            return false;
+        }
+    }
+
+    COUNT_STAT(dp_words, (max >= M) ? 2 * (max - M + 1) : 0);
+    return true;
+}
+
+/**
+ *  Tests the subsets ranked first_rank + iteration to first_rank + subsets_in_run - 1 in revolving door order (see
+ *  generate_ith_subset_rd), updating the sum counts with the element removed and the element added by each move.
+ */
+void test_subsets_revolving_door(subset_tester &tester, const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail) {
+    const unsigned int M = max_set_value;
+    const unsigned int free_elements = subset_size - 1;
+
+    revolving_door_enumerator enumerator(max_set_value, subset_size);
+    enumerator.seek(first_rank + iteration);
+    const unsigned int *subset = enumerator.subset;
+
+    sum_counts sc;
+    new_sum_counts(sc, max_sums_length * ELEMENT_SIZE);
+    for (unsigned int i = 0; i < free_elements; i++) add_sum_count(sc, subset[i]);
+
+    bool success, complete;
+
+    while (iteration < subsets_in_run) {
+#ifdef RUN_STATS
+        stats_sample sample;
+        start_stats_sample(sample);
+#endif
+        unsigned int max = sums_test_max(M, sc.total + M);
+        accept_filter filter = accept_subset(M, max, contiguous_sums(subset, free_elements, complete));
+        tester.checker.accept_filter_counts[filter]++;
+        COUNT_STAT(sums_tests, filter == ACCEPT_NONE);
+
+        success = (filter != ACCEPT_NONE) || counts_all_ones(sc, M, max);
+        if (needs_test_subset(success)) retest_subset(tester, subset, subset_size, 0, enumerator.rank, success);
+
+        if (success)    pass++;
+        else            fail++;
+
+        iteration++;
+
+#ifdef RUN_STATS
+        lap_stats_sample(sample, shared_stats::thread_stats.testing_seconds);
+#endif
+
+        if (iteration < subsets_in_run) {
+            enumerator.next();
+#ifdef RUN_STATS
+            lap_stats_sample(sample, shared_stats::thread_stats.enumeration_seconds);
+#endif
+            remove_sum_count(sc, enumerator.removed);
+            add_sum_count(sc, enumerator.added);
+        }
+#ifdef RUN_STATS
+        lap_stats_sample(sample, shared_stats::thread_stats.testing_seconds);
+        end_stats_sample(sample);
+#endif
+
+#ifdef ENABLE_CHECKPOINTING
+        if (progress_due()) {
+            bool checkpoint = take_checkpoint_due();
+            if (checkpoint) flush_results(tester.results);
+            update_progress(iteration, subsets_in_run, pass, fail, checkpoint);
+        }
+#endif
+    }
+
+    delete_sum_counts(sc);
+}
+
+#ifdef ENUMERATION_BENCHMARK
+/**
+ *  With -DENUMERATION_BENCHMARK, the client only times how fast each enumerator lists the subsets of the run (without
+ *  testing them), and prints the throughput of each.  The checksum (of the first changed element of every subset) keeps
+ *  the enumeration from being optimized away.
+ */
+void benchmark_enumerators(const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run) {
+    for (unsigned int order = 0; order < SUBSET_ORDERS; order++) {
+        subset_enumerator *enumerator = new_subset_enumerator((subset_order)order, max_set_value, subset_size);
+
+        clock_t start = clock();
+        unsigned long long count = 0;
+        unsigned long long checksum = 0;
+
+        for (enumerator->seek(first_rank); count < subsets_in_run && !enumerator->done(); enumerator->next()) {
+            checksum += enumerator->subset[enumerator->changed_from_position()];
+            count++;
+        }
+
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        fprintf(stderr, "%-16s %llu subsets in %.3lf seconds, %.1lf million subsets per second (checksum %llu).\n", subset_order_names[order], count, seconds, (seconds > 0) ? (count / seconds) / 1e6 : 0.0, checksum);
+
+        delete enumerator;
+    }
+}
+#endif
+
+#ifdef KERNEL_BENCHMARK
+#if defined(VERBOSE) || defined(BINARY_OUTPUT)
+#error "KERNEL_BENCHMARK cannot be used with VERBOSE or BINARY_OUTPUT"
+#endif
+
+/**
+ *  With -DKERNEL_BENCHMARK, the client times each of the kernels used to test subsets (and the whole of testing a
+ *  subset) on the subsets of the run instead of testing them, appending a line for each kernel to kernel_benchmark_file
+ *  (tab separated, with a header line when the file is new):
+ *
+ *      kernel  M  N  word_bits  subsets  seconds  subsets_per_second  ns_per_subset  bytes_per_subset  checksum
+ *
+ *  The bitset kernels are run on a sample of KERNEL_BENCHMARK_SAMPLE subsets spread over the run (over and over, until
+ *  they've been run for as many subsets as there are in the run), once for each element of the subset, with the sums
+ *  of the subset as their input.  bytes_per_subset is how many bytes of the bitsets (or subset) the kernel reads and
+ *  writes for each subset, counting each element once, and is 0 for test_subsets, which also skips and sweeps
+ *  subsets.  The checksum keeps the results from being optimized away.  bin/benchmark_kernels.sh runs this on a grid
+ *  of workunits.
+ */
+const unsigned int KERNEL_BENCHMARK_SAMPLE = 256;
+
+string kernel_benchmark_file = "kernel_benchmark.tsv";
+
+struct kernel_timer {
+    const char *kernel;
+    clock_t start;
+    double bytes;
+    unsigned long long checksum;
+};
+
+static void start_kernel_timer(kernel_timer &timer, const char *kernel) {
+    timer.kernel = kernel;
+    timer.bytes = 0;
+    timer.checksum = 0;
+    timer.start = clock();
+}
+
+static void write_kernel_timer(FILE *output, const kernel_timer &timer, const unsigned int max_set_value, const unsigned int subset_size, const unsigned long long subsets) {
+    double seconds = (double)(clock() - timer.start) / CLOCKS_PER_SEC;
+
+    fprintf(output, "%s\t%u\t%u\t%u\t%llu\t%.6lf\t%.1lf\t%.3lf\t%.1lf\t%llu\n", timer.kernel, max_set_value, subset_size, (unsigned int)ELEMENT_SIZE, subsets, seconds,
+            (seconds > 0) ? subsets / seconds : 0.0, (subsets > 0) ? (seconds * 1e9) / subsets : 0.0, (subsets > 0) ? timer.bytes / subsets : 0.0, timer.checksum);
+    fprintf(stderr, "%-24s %.3lf seconds, %.1lf million subsets per second.\n", timer.kernel, seconds, (seconds > 0) ? (subsets / seconds) / 1e6 : 0.0);
+}
+
+typedef void (*shift_or_function)(sums_word_t *dest, const unsigned int length, const sums_word_t *src, const unsigned int shift);
+
+struct shift_or_version {
+    const char *kernel;
+    shift_or_function function;
+    bool supported;
+};
+
+void benchmark_kernels(const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run) {
+    FILE *output = fopen(kernel_benchmark_file.c_str(), "a");
+    if (output == NULL) {
+        fprintf(stderr, "ERROR: could not open '%s'.\n", kernel_benchmark_file.c_str());
+        exit(0);
+    }
+    if (ftell(output) == 0) fprintf(output, "kernel\tM\tN\tword_bits\tsubsets\tseconds\tsubsets_per_second\tns_per_subset\tbytes_per_subset\tchecksum\n");
+
+    const unsigned int length = max_sums_length;
+    const unsigned int word_size = sizeof(sums_word_t);
+
+    unsigned long int sums_length;
+    sums_test_function test_sums = select_sums_kernel(max_set_value, subset_size, sums_length);
+
+    /**
+     *  The sample subsets, and the sums of each (calculated over the whole length).
+     */
+    unsigned int samples = KERNEL_BENCHMARK_SAMPLE;
+    if (subsets_in_run < samples) samples = (unsigned int)subsets_in_run;
+
+    unsigned int *sample_subsets = new unsigned int[samples * subset_size];
+    sums_word_t *sample_sums = new sums_word_t[samples * length];
+    sums_word_t *stack = new sums_word_t[subset_size * length];
+    unsigned int *live = new_live_lengths(subset_size, length);
+    sums_word_t *dest = new sums_word_t[length];
+
+    for (unsigned int i = 0; i < samples; i++) {
+        unsigned int *subset = sample_subsets + (i * subset_size);
+        generate_ith_subset(first_rank + ((subset_rank_t)subsets_in_run * i) / samples, subset, subset_size, max_set_value);
+
+        calculate_sums(stack, live, length, subset, subset_size, 0);
+        memcpy(sample_sums + (i * length), stack + ((subset_size - 1) * length), length * word_size);
+        for (unsigned int j = 0; j < subset_size; j++) live[j] = length;
+    }
+    memset(dest, 0, length * word_size);
+
+    kernel_timer timer;
+    unsigned int sample;
+    unsigned long long count;
+
+#define FOR_EACH_SAMPLE for (count = 0, sample = 0; count < subsets_in_run; count++, sample = (sample + 1 == samples) ? 0 : sample + 1)
+#define SAMPLE_SUBSET (sample_subsets + (sample * subset_size))
+#define SAMPLE_SUMS (sample_sums + (sample * length))
+
+    start_kernel_timer(timer, "shift_left");
+    FOR_EACH_SAMPLE {
+        for (unsigned int j = 0; j < subset_size; j++) shift_left(dest, length, SAMPLE_SUMS, SAMPLE_SUBSET[j]);
+        timer.checksum += dest[length / 2];
+    }
+    timer.bytes = (double)subsets_in_run * subset_size * 2 * length * word_size;
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    start_kernel_timer(timer, "or_equal");
+    FOR_EACH_SAMPLE {
+        for (unsigned int j = 0; j < subset_size; j++) or_equal(dest, length, SAMPLE_SUMS);
+        timer.checksum += dest[length / 2];
+    }
+    timer.bytes = (double)subsets_in_run * subset_size * 3 * length * word_size;
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    start_kernel_timer(timer, "or_single");
+    FOR_EACH_SAMPLE {
+        for (unsigned int j = 0; j < subset_size; j++) or_single(dest, length, SAMPLE_SUBSET[j] - 1);
+        timer.checksum += dest[length / 2];
+    }
+    timer.bytes = (double)subsets_in_run * subset_size * 2 * word_size;
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    /**
+     *  Each version of shift_or this CPU supports, not just the one select_shift_or_kernel picked.
+     */
+    shift_or_version versions[] = {
+        { "shift_or_portable", shift_or_portable<sums_word_t>, true },
+#ifdef SIMD_DISPATCH
+        { "shift_or_sse2", shift_or_sse2<sums_word_t>, __builtin_cpu_supports("sse2") != 0 },
+        { "shift_or_avx2", shift_or_avx2<sums_word_t>, __builtin_cpu_supports("avx2") != 0 },
+        { "shift_or_avx512", shift_or_avx512<sums_word_t>, __builtin_cpu_supports("avx512f") != 0 },
+#endif
+    };
+
+    for (unsigned int i = 0; i < sizeof(versions) / sizeof(shift_or_version); i++) {
+        if (!versions[i].supported) continue;
+
+        shift_or_function function = versions[i].function;
+        start_kernel_timer(timer, versions[i].kernel);
+        FOR_EACH_SAMPLE {
+            for (unsigned int j = 0; j < subset_size; j++) function(dest, length, SAMPLE_SUMS, SAMPLE_SUBSET[j]);
+            timer.checksum += dest[length / 2];
+        }
+        timer.bytes = (double)subsets_in_run * subset_size * 2 * length * word_size;
+        write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+    }
+
+    start_kernel_timer(timer, "all_ones");
+    FOR_EACH_SAMPLE {
+        const unsigned int *subset = SAMPLE_SUBSET;
+        unsigned int M = subset[subset_size - 1];
+        unsigned int subset_sum = 0;
+        for (unsigned int j = 0; j < subset_size; j++) subset_sum += subset[j];
+
+        unsigned int max = sums_test_max(M, subset_sum);
+        if (all_ones(SAMPLE_SUMS, length, M, max)) timer.checksum++;
+        if (max >= M) timer.bytes += (((max - 1) / ELEMENT_SIZE) - ((M - 1) / ELEMENT_SIZE) + 1) * word_size;
+    }
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    /**
+     *  The sums test picked for this M and N (see select_sums_test), recalculating the whole sums stack each time.
+     */
+    start_kernel_timer(timer, (test_sums == test_sums_generic) ? "test_sums_generic" : "test_sums_fixed");
+    FOR_EACH_SAMPLE {
+        const unsigned int *subset = SAMPLE_SUBSET;
+        unsigned int M = subset[subset_size - 1];
+        unsigned int subset_sum = 0;
+        for (unsigned int j = 0; j < subset_size; j++) subset_sum += subset[j];
+
+        if (test_sums(stack, live, length, subset, subset_size, 0, M, sums_test_max(M, subset_sum))) timer.checksum++;
+    }
+    timer.bytes = (double)subsets_in_run * (2 * subset_size + 1) * length * word_size;
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+#undef FOR_EACH_SAMPLE
+#undef SAMPLE_SUBSET
+#undef SAMPLE_SUMS
+
+    unsigned int *subset = new unsigned int[subset_size];
+
+    start_kernel_timer(timer, "generate_ith_subset");
+    for (count = 0; count < subsets_in_run; count++) {
+        generate_ith_subset(first_rank + count, subset, subset_size, max_set_value);
+        timer.checksum += subset[0];
+    }
+    timer.bytes = (double)subsets_in_run * subset_size * sizeof(unsigned int);
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    generate_ith_subset(first_rank, subset, subset_size, max_set_value);
+    start_kernel_timer(timer, "generate_next_subset_td");
+    for (count = 1; count < subsets_in_run; count++) {
+        unsigned int changed_from = generate_next_subset_td(subset, subset_size, max_set_value);
+        timer.checksum += changed_from;
+        timer.bytes += (subset_size - changed_from) * sizeof(unsigned int);
+    }
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    delete [] subset;
+
+    /**
+     *  Every subset of the run tested (in lexicographic order) with test_subset, and then the way the client tests them.
+     */
+    subset_tester tester;
+    new_subset_tester(tester, max_set_value, subset_size, output_target);
+
+    lexicographic_enumerator enumerator(max_set_value, subset_size);
+    start_kernel_timer(timer, "test_subset");
+    for (enumerator.seek(first_rank), count = 0; count < subsets_in_run; enumerator.next(), count++) {
+        unsigned int changed_from = enumerator.changed_from_position();
+        if (test_subset(tester, enumerator.subset, subset_size, changed_from, enumerator.rank)) timer.checksum++;
+        timer.bytes += (2 * (subset_size - changed_from) + 1) * length * word_size;
+    }
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    unsigned long long iteration = 0, pass = 0, fail = 0;
+    reset_subset_tester(tester, max_set_value, subset_size);
+    start_kernel_timer(timer, "test_subsets");
+    test_subsets(tester, LEXICOGRAPHIC_ORDER, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail);
+    timer.checksum = pass;
+    write_kernel_timer(output, timer, max_set_value, subset_size, subsets_in_run);
+
+    delete_subset_tester(tester);
+
+    delete [] sample_subsets;
+    delete [] sample_sums;
+    delete [] stack;
+    delete [] live;
+    delete [] dest;
+
+    fclose(output);
+}
+#endif
+
+#ifdef ENABLE_THREADS
+/**
+ *  With --threads, the subsets to test are split into chunks of consecutive ranks.  Each thread starts with an equal
+ *  share of the chunks, and takes them from the front of its share.  When a thread runs out, it steals the back half of
+ *  the largest share left.
+ *
+ *  Each thread prints to its own temporary file.  As chunks finish, the main thread copies the output of the finished
+ *  chunks (in rank order) to output_target and adds up their pass and fail counts, so the output is the same as a
+ *  single threaded run.
+ */
+const unsigned int CHUNKS_PER_THREAD = 64;
+
+struct subset_chunk {
+    subset_rank_t first_rank;
+    unsigned long long count;
+    unsigned long long pass;
+    unsigned long long fail;
+    unsigned int thread;
+    long long output_start;
+    long long output_end;
+    bool done;
+};
+
+struct chunk_thread {
+    pthread_t id;
+    unsigned int number;
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    FILE *output;
+    unsigned long next_chunk;
+    unsigned long end_chunk;
+};
+
+pthread_mutex_t chunk_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t chunk_finished = PTHREAD_COND_INITIALIZER;
+
+subset_chunk *chunks;
+chunk_thread *chunk_threads;
+unsigned int number_chunk_threads;
+
+/**
+ *  Gets the next chunk for a thread to test (stealing if it has none left), returns false if there are no chunks left.
+ *  chunk_mutex must be held.
+ */
+static bool get_chunk(chunk_thread &thread, unsigned long &chunk) {
+    if (thread.next_chunk == thread.end_chunk) {
+        chunk_thread *victim = NULL;
+        for (unsigned int i = 0; i < number_chunk_threads; i++) {
+            unsigned long remaining = chunk_threads[i].end_chunk - chunk_threads[i].next_chunk;
+            if (remaining > 0 && (victim == NULL || remaining > (victim->end_chunk - victim->next_chunk))) victim = &chunk_threads[i];
+        }
+        if (victim == NULL) return false;
+
+        unsigned long middle = victim->next_chunk + ((victim->end_chunk - victim->next_chunk) / 2);
+        thread.next_chunk = middle;
+        thread.end_chunk = victim->end_chunk;
+        victim->end_chunk = middle;
+    }
+
+    chunk = thread.next_chunk++;
+    return true;
+}
+
+template <typename enumerator_t>
+static void* test_chunks(void *arguments) {
+    chunk_thread &thread = *((chunk_thread*)arguments);
+
+    subset_tester tester;
+    new_subset_tester(tester, thread.max_set_value, thread.subset_size, thread.output);
+
+    enumerator_t enumerator(thread.max_set_value, thread.subset_size);
+
+    unsigned long current_chunk;
+    pthread_mutex_lock(&chunk_mutex);
+    while (get_chunk(thread, current_chunk)) {
+        pthread_mutex_unlock(&chunk_mutex);
+
+        subset_chunk &chunk = chunks[current_chunk];
+        unsigned long long pass = 0, fail = 0;
+
+        chunk.output_start = output_tell(thread.output);
+        enumerator.seek(chunk.first_rank);
+        for (unsigned long long i = 0; i < chunk.count; i++) {
+#ifdef RUN_STATS
+            stats_sample sample;
+            start_stats_sample(sample);
+#endif
+            if (test_next_subset<enumerator_t::sweeps_last_element>(tester, enumerator.subset, thread.subset_size, enumerator.changed_from_position(), enumerator.rank, chunk.count - i)) pass++;
+            else fail++;
+#ifdef RUN_STATS
+            lap_stats_sample(sample, shared_stats::thread_stats.testing_seconds);
+#endif
+
+            enumerator.next();
+#ifdef RUN_STATS
+            lap_stats_sample(sample, shared_stats::thread_stats.enumeration_seconds);
+            end_stats_sample(sample);
+#endif
+        }
+        flush_results(tester.results);
+        chunk.output_end = output_tell(thread.output);
+
+        pthread_mutex_lock(&chunk_mutex);
+        chunk.pass = pass;
+        chunk.fail = fail;
+        chunk.thread = thread.number;
+        chunk.done = true;
+        pthread_cond_signal(&chunk_finished);
+    }
+    delete_subset_tester(tester);   //this adds to accept_filter_counts, so needs chunk_mutex
+    pthread_mutex_unlock(&chunk_mutex);
+
+    return NULL;
+}
+
+/**
+ *  Copies the output of a finished chunk from its thread's temporary file to output_target.
+ */
+static void write_chunk_output(const subset_chunk &chunk) {
+    char buffer[65536];
+    long long position = chunk.output_start;
+#ifdef RUN_STATS
+    double start = stats_time();
+#endif
+
+    while (position < chunk.output_end) {
+        size_t to_read = sizeof(buffer);
+        if ((long long)to_read > chunk.output_end - position) to_read = (size_t)(chunk.output_end - position);
+
+        long bytes_read = read_output(chunk_threads[chunk.thread].output, buffer, to_read, position);
+        if (bytes_read <= 0) {
+            fprintf(stderr, "ERROR: could not read the output of thread %u.\n", chunk.thread);
+            exit(1);
+        }
+
+        fwrite(buffer, 1, bytes_read, output_target);
+        position += bytes_read;
+    }
+
+#ifdef RUN_STATS
+    COUNT_STAT(output_writes, 1);
+    COUNT_STAT(output_seconds, stats_time() - start);
+#endif
+}
+
+/**
+ *  Threaded version of test_subsets.
+ */
+void test_subsets_threaded(const unsigned int number_threads, const subset_order order, const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail) {
+    unsigned long long remaining = subsets_in_run - iteration;
+    unsigned long long chunk_size = (remaining / (number_threads * CHUNKS_PER_THREAD)) + 1;
+    unsigned long number_chunks = (remaining + chunk_size - 1) / chunk_size;
+
+    chunks = new subset_chunk[number_chunks];
+    for (unsigned long i = 0; i < number_chunks; i++) {
+        chunks[i].first_rank = first_rank + iteration + (i * chunk_size);
+        chunks[i].count = (i == number_chunks - 1) ? remaining - (i * chunk_size) : chunk_size;
+        chunks[i].done = false;
+    }
+
+    number_chunk_threads = number_threads;
+    chunk_threads = new chunk_thread[number_threads];
+    for (unsigned int i = 0; i < number_threads; i++) {
+        chunk_threads[i].number = i;
+        chunk_threads[i].max_set_value = max_set_value;
+        chunk_threads[i].subset_size = subset_size;
+        chunk_threads[i].next_chunk = (number_chunks * i) / number_threads;
+        chunk_threads[i].end_chunk = (number_chunks * (i + 1)) / number_threads;
+        chunk_threads[i].output = tmpfile();
+        if (chunk_threads[i].output == NULL) {
+            fprintf(stderr, "ERROR: could not open a temporary output file for thread %u.\n", i);
+            exit(1);
+        }
+    }
+
+    for (unsigned int i = 0; i < number_threads; i++) {
+        pthread_create(&chunk_threads[i].id, NULL, (order == JUN_LIU_ORDER) ? test_chunks<jun_liu_enumerator> : test_chunks<lexicographic_enumerator>, &chunk_threads[i]);
+    }
+
+    unsigned long next_to_write = 0;
+    while (next_to_write < number_chunks) {
+        pthread_mutex_lock(&chunk_mutex);
+        while (!chunks[next_to_write].done) pthread_cond_wait(&chunk_finished, &chunk_mutex);
+
+        unsigned long finished_end = next_to_write;
+        while (finished_end < number_chunks && chunks[finished_end].done) finished_end++;
+        pthread_mutex_unlock(&chunk_mutex);
+
+        for (; next_to_write < finished_end; next_to_write++) {
+            write_chunk_output(chunks[next_to_write]);
+            pass += chunks[next_to_write].pass;
+            fail += chunks[next_to_write].fail;
+            iteration += chunks[next_to_write].count;
+        }
+        fflush(output_target);
+
+#ifdef ENABLE_CHECKPOINTING
+        if (progress_due()) update_progress(iteration, subsets_in_run, pass, fail, take_checkpoint_due());
+#endif
+    }
+
+    for (unsigned int i = 0; i < number_threads; i++) {
+        pthread_join(chunk_threads[i].id, NULL);
+        fclose(chunk_threads[i].output);
+    }
+
+    delete [] chunk_threads;
+    delete [] chunks;
+}
+#endif
+
+/**
+ *  Tests the subsets ranked first_rank + iteration to first_rank + subsets_in_run - 1 in order, with tester or (with
+ *  --threads) a tester for each thread, and writes out what's left in tester's result buffer.
+ */
+void test_run(subset_tester &tester, const unsigned int number_threads, const subset_order order, const unsigned int max_set_value, const unsigned int subset_size, const subset_rank_t first_rank, const unsigned long long subsets_in_run, unsigned long long &iteration, unsigned long long &pass, unsigned long long &fail) {
+    if (order == REVOLVING_DOOR_ORDER) {
+        test_subsets_revolving_door(tester, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail);
+#ifdef ENABLE_THREADS
+    } else if (number_threads > 1) {
+        test_subsets_threaded(number_threads, order, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail);
+#endif
+    } else {
+        test_subsets(tester, order, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail);
+    }
+    flush_results(tester.results);
+}
+
+
+#ifdef RUN_STATS
+/**
+ *  With -DRUN_STATS, the counters in run_stats.hpp are written as JSON to run_stats_file at the end of a run, and with
+ *  -DRUN_STATS_EXTRA_INFO (and -D_BOINC_) to the <extra_info> block of the output as well.  The counts are for this run
+ *  only, so after starting from a checkpoint they leave out the subsets tested before it (but pass and fail are the
+ *  totals).  The processor time not spent writing output or checkpoints is split into enumeration and testing seconds
+ *  in proportion to how long each took for the sampled subsets (so with --threads they are added up over the threads).
+ *  A --sweep has one set of stats for all of its pairs, with M and N the largest of them.
+ */
+string run_stats_file = "run_stats.json";
+
+struct run_totals {
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    bool sweep;
+    unsigned int first_set_value;
+    unsigned int first_subset_size;
+    unsigned int pairs;
+    subset_order order;
+    unsigned int threads;
+    unsigned long long subsets;
+    unsigned long long pass;
+    unsigned long long fail;
+    double wall_seconds;
+    double cpu_seconds;
+};
+
+void print_run_stats(FILE *output, const run_totals &totals) {
+    const run_counters &stats = shared_stats::run_stats;
+
+    double sampled_seconds = stats.enumeration_seconds + stats.testing_seconds;
+    double subset_seconds = totals.cpu_seconds - stats.output_seconds - stats.checkpoint_seconds;
+    if (subset_seconds < 0) subset_seconds = 0;
+    double enumeration_share = (sampled_seconds > 0) ? stats.enumeration_seconds / sampled_seconds : 0.0;
+
+    fprintf(output, "{\n");
+    fprintf(output, "  \"M\": %u,\n", totals.max_set_value);
+    fprintf(output, "  \"N\": %u,\n", totals.subset_size);
+    if (totals.sweep) {
+        fprintf(output, "  \"sweep\": { \"first_M\": %u, \"last_M\": %u, \"first_N\": %u, \"last_N\": %u, \"pairs\": %u },\n", totals.first_set_value, totals.max_set_value, totals.first_subset_size, totals.subset_size, totals.pairs);
+    }
+    fprintf(output, "  \"order\": \"%s\",\n", subset_order_names[totals.order]);
+    fprintf(output, "  \"threads\": %u,\n", totals.threads);
+    fprintf(output, "  \"word_bits\": %u,\n", (unsigned int)ELEMENT_SIZE);
+    fprintf(output, "  \"shift_or_kernel\": \"%s\",\n", shift_or_dispatch::kernel_name);
+    fprintf(output, "  \"subsets\": %llu,\n", totals.subsets);
+    fprintf(output, "  \"pass\": %llu,\n", totals.pass);
+    fprintf(output, "  \"fail\": %llu,\n", totals.fail);
+    fprintf(output, "  \"wall_seconds\": %.6lf,\n", totals.wall_seconds);
+    fprintf(output, "  \"cpu_seconds\": %.6lf,\n", totals.cpu_seconds);
+    fprintf(output, "  \"accept_filters\": { \"empty_range\": %llu, \"contiguous_sums\": %llu, \"sums_bitsets\": %llu },\n", accept_filter_counts[ACCEPT_EMPTY_RANGE], accept_filter_counts[ACCEPT_CONTIGUOUS_SUMS], accept_filter_counts[ACCEPT_NONE]);
+    fprintf(output, "  \"sums_tests\": %llu,\n", stats.sums_tests);
+    fprintf(output, "  \"sweeps\": %llu,\n", stats.sweeps);
+    fprintf(output, "  \"dp_words\": %llu,\n", stats.dp_words);
+    fprintf(output, "  \"early_exits\": %llu,\n", stats.early_exits);
+    fprintf(output, "  \"timed_subsets\": %llu,\n", stats.timed_subsets);
+    fprintf(output, "  \"enumeration_seconds\": %.6lf,\n", subset_seconds * enumeration_share);
+    fprintf(output, "  \"testing_seconds\": %.6lf,\n", subset_seconds * (1 - enumeration_share));
+    fprintf(output, "  \"output_writes\": %llu,\n", stats.output_writes);
+    fprintf(output, "  \"output_seconds\": %.6lf,\n", stats.output_seconds);
+    fprintf(output, "  \"checkpoints\": %llu,\n", stats.checkpoints);
+    fprintf(output, "  \"checkpoint_seconds\": %.6lf,\n", stats.checkpoint_seconds);
+
+    fprintf(output, "  \"hardware_counters\": {");
+    bool first = true;
+    for (unsigned int i = 0; i < HARDWARE_COUNTERS_COUNT; i++) {
+        unsigned long long value;
+        if (!read_hardware_counter(i, value)) continue;
+
+        fprintf(output, "%s \"%s\": %llu", first ? "" : ",", hardware_counters[i].name, value);
+        first = false;
+    }
+    fprintf(output, "%s}\n", first ? "" : " ");
+    fprintf(output, "}\n");
+}
+
+void write_run_stats(string filename, const run_totals &totals) {
+#ifdef _BOINC_
+    string output_path;
+    int retval = boinc_resolve_filename_s(filename.c_str(), output_path);
+    if (retval) {
+        fprintf(stderr, "APP: error writing run stats (resolving run stats file name)\n");
+        return;
+    }
+#else
+    string output_path = filename;
+#endif
+
+    FILE *stats_file = fopen(output_path.c_str(), "w");
+    if (stats_file == NULL) {
+        fprintf(stderr, "APP: error writing run stats (opening run stats file)\n");
+        return;
+    }
+
+    print_run_stats(stats_file, totals);
+    fclose(stats_file);
+}
+#endif
 
-    if (argc != 3 && argc != 5) {
+/**
+ *  With --sweep, every M from first_M to last_M and N from first_N to last_N (with N <= M) is tested one after another
+ *  in this process, instead of starting a process for each.  The binomials are made once for the largest M and N, and
+ *  one tester is reset for each pair (see reset_subset_tester), so its bitsets and result buffer are reused.  Instead
+ *  of a report, each pair gets a line with its totals (after its failed sets with -DVERBOSE), followed by the totals
+ *  of the whole sweep, and with -DRUN_STATS one run_stats.json for the whole sweep.  Sweeps aren't checkpointed.
+ */
+void test_sweep(const unsigned int number_threads, const subset_order order, const unsigned int first_M, const unsigned int last_M, const unsigned int first_N, const unsigned int last_N) {
+    const unsigned int largest_N = (last_N < last_M) ? last_N : last_M;
+
+    if (order == REVOLVING_DOOR_ORDER && largest_N - 1 > MAX_COUNTED_ELEMENTS) {
+        fprintf(stderr, "Error --order revolving_door only works with subset sizes up to %u. Quitting.\n", MAX_COUNTED_ELEMENTS + 1);
+        exit(0);
+    }
+
+    init_binomials(last_M - 1, largest_N - 1);
+
+    /**
+     *  Every pair needs to fit in one run, which is checked before any of them are tested.
+     */
+    unsigned int pairs = 0;
+    for (unsigned int M = first_M; M <= last_M; M++) {
+        for (unsigned int N = first_N; N <= last_N && N <= M; N++) {
+            subset_rank_t expected_total = n_choose_k(M - 1, N - 1);
+            if (expected_total == MAX_RANK || expected_total > ULLONG_MAX) {
+                fprintf(stderr, "Error there are too many sets of %u from 1..%u containing %u to test in one run. Quitting.\n", N, M, M);
+                exit(0);
+            }
+            pairs++;
+        }
+    }
+
+#ifdef RUN_STATS
+    init_stats_clock();
+    start_hardware_counters();
+
+    run_totals totals;
+    totals.max_set_value = last_M;
+    totals.subset_size = largest_N;
+    totals.sweep = true;
+    totals.first_set_value = first_M;
+    totals.first_subset_size = first_N;
+    totals.pairs = pairs;
+    totals.order = order;
+    totals.threads = number_threads;
+    totals.subsets = 0;
+
+    double stats_start = stats_time();
+    clock_t stats_cpu_start = clock();
+#endif
+
+    set_sums_lengths(last_M, largest_N);
+    subset_tester tester;
+    new_subset_tester(tester, last_M, largest_N, output_target);
+
+    unsigned long long sweep_pass = 0;
+    unsigned long long sweep_fail = 0;
+    double sweep_start = wall_time();
+
+    for (unsigned int M = first_M; M <= last_M; M++) {
+        for (unsigned int N = first_N; N <= last_N && N <= M; N++) {
+            double start = wall_time();
+            unsigned long long subsets_in_run = (unsigned long long)n_choose_k(M - 1, N - 1);
+            unsigned long long iteration = 0;
+            unsigned long long pass = 0;
+            unsigned long long fail = 0;
+
+            init_report_widths(M, subsets_in_run);
+            set_sums_lengths(M, N);
+            reset_subset_tester(tester, M, N);
+            test_run(tester, number_threads, order, M, N, 0, subsets_in_run, iteration, pass, fail);
+
+            fprintf(output_target, "%u choose %u: %llu total sets, %llu sets passed, %llu sets failed, %lf success rate, %.6lf seconds.\n", M, N, pass + fail, pass, fail, ((double)pass / ((double)pass + (double)fail)), wall_time() - start);
+            sweep_pass += pass;
+            sweep_fail += fail;
+        }
+    }
+
+    delete_subset_tester(tester);
+
+    fprintf(output_target, "sweep of %u pairs: %llu total sets, %llu sets passed, %llu sets failed, %lf success rate, %.6lf seconds.\n", pairs, sweep_pass + sweep_fail, sweep_pass, sweep_fail, ((double)sweep_pass / ((double)sweep_pass + (double)sweep_fail)), wall_time() - sweep_start);
+    fflush(output_target);
+
+#ifdef RUN_STATS
+    add_thread_stats();
+
+    totals.subsets = sweep_pass + sweep_fail;
+    totals.pass = sweep_pass;
+    totals.fail = sweep_fail;
+    totals.wall_seconds = stats_time() - stats_start;
+    totals.cpu_seconds = (double)(clock() - stats_cpu_start) / CLOCKS_PER_SEC;
+    write_run_stats(run_stats_file, totals);
+#endif
+
+#ifndef NO_ACCEPT_FILTER
+    fprintf(stderr, "accept filters: %llu empty range, %llu contiguous sums, %llu tested with the sums bitsets.\n", accept_filter_counts[ACCEPT_EMPTY_RANGE], accept_filter_counts[ACCEPT_CONTIGUOUS_SUMS], accept_filter_counts[ACCEPT_NONE]);
+#endif
+}
+
+/**
+ *  With --daemon, jobs are read from stdin one line at a time (or with --socket <path>, from each connection to a Unix
+ *  socket, one connection after another), each being the <M> <N> [<i> <count>] of a run:
+ *
+ *      40 6 1000 5000
+ *
+ *  and answered with a result record on stdout (or the connection) once it has been tested:
+ *
+ *      result <M> <N> <i> <count> <pass> <fail> <seconds>
+ *
+ *  where <i> and <count> are the subsets that were tested (all of them for a job without <i> and <count>), or with
+ *  "error <message>" if the job can't be run.  Blank lines are skipped.  With -DVERBOSE the failed sets of a job are
+ *  printed before its result.  The binomial table (see reserve_binomials) and the tester (see reset_subset_tester) are
+ *  kept between jobs, so a job only costs its testing.  Jobs aren't checkpointed.
+ */
+const unsigned int MAX_JOB_LENGTH = 256;
+
+struct daemon_job {
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    subset_rank_t first_rank;
+    unsigned long long count;
+};
+
+/**
+ *  Reads a job from line, returning false (with why in error) if it isn't a job this build can run.
+ */
+static bool parse_job(char *line, const subset_order order, daemon_job &job, const char *&error) {
+    char *arguments[5];
+    unsigned int number_arguments = 0;
+
+    for (char *argument = strtok(line, " \t\r\n"); argument != NULL; argument = strtok(NULL, " \t\r\n")) {
+        if (number_arguments == 5) break;
+        arguments[number_arguments++] = argument;
+    }
+
+    subset_rank_t max_set_value, subset_size, first_rank = 0, count = MAX_RANK;
+    if ((number_arguments != 2 && number_arguments != 4) || !parse_rank(arguments[0], max_set_value) || !parse_rank(arguments[1], subset_size)) {
+        error = "a job is <M> <N> [<i> <count>]";
+        return false;
+    }
+    if (number_arguments == 4 && (!parse_rank(arguments[2], first_rank) || !parse_rank(arguments[3], count))) {
+        error = "<i> and <count> must be whole numbers";
+        return false;
+    }
+    if (subset_size == 0 || max_set_value < subset_size || max_set_value > UINT_MAX) {
+        error = "<N> must be from 1 to <M>";
+        return false;
+    }
+    if (order == REVOLVING_DOOR_ORDER && subset_size - 1 > MAX_COUNTED_ELEMENTS) {
+        error = "--order revolving_door only works with subset sizes up to 32";
+        return false;
+    }
+
+    job.max_set_value = (unsigned int)max_set_value;
+    job.subset_size = (unsigned int)subset_size;
+
+    /**
+     *  The job is checked with a binomial worked out without the table, so a job which is turned down doesn't make
+     *  the table (kept for the life of the daemon) any bigger.
+     */
+    subset_rank_t expected_total = binomial(job.max_set_value - 1, job.subset_size - 1);
+    if (expected_total == MAX_RANK) {
+        error = "there are too many subsets to rank";
+        return false;
+    }
+    if (first_rank >= expected_total) {
+        error = "<i> is past the last subset";
+        return false;
+    }
+    if (count > expected_total - first_rank) count = expected_total - first_rank;
+    if (count > ULLONG_MAX) {
+        error = "cannot test that many subsets in one job";
+        return false;
+    }
+
+    try {
+        reserve_binomials(job.max_set_value - 1, job.subset_size - 1);
+    } catch (const std::bad_alloc &) {
+        error = "not enough memory for the binomial table of the job";
+        return false;
+    }
+
+    job.first_rank = first_rank;
+    job.count = (unsigned long long)count;
+    return true;
+}
+
+/**
+ *  Runs the jobs read from input until it ends, writing their results to output.  The tester is made by the first job.
+ *  With -DENABLE_CHECKPOINTING, a job's checkpoints are written to output as "checkpoint <done> <pass> <fail>" lines
+ *  (after the failed sets found before them), so whatever sent the job can tell how far it got.
+ */
+static void serve_jobs(FILE *input, FILE *output, subset_tester &tester, bool &tester_made, const unsigned int number_threads, const subset_order order) {
+    char line[MAX_JOB_LENGTH];
+    output_target = output;
+    if (tester_made) tester.results.output = output;
+
+    while (fgets(line, MAX_JOB_LENGTH, input) != NULL) {
+        if (strspn(line, " \t\r\n") == strlen(line)) continue;
+
+        daemon_job job;
+        const char *error;
+        if (!parse_job(line, order, job, error)) {
+            fprintf(output, "error %s\n", error);
+            fflush(output);
+            continue;
+        }
+
+        double start = wall_time();
+        unsigned long long iteration = 0;
+        unsigned long long pass = 0;
+        unsigned long long fail = 0;
+
+        init_report_widths(job.max_set_value, n_choose_k(job.max_set_value - 1, job.subset_size - 1));
+        set_sums_lengths(job.max_set_value, job.subset_size);
+        if (tester_made) {
+            reset_subset_tester(tester, job.max_set_value, job.subset_size);
+        } else {
+            new_subset_tester(tester, job.max_set_value, job.subset_size, output);
+            tester_made = true;
+        }
+        test_run(tester, number_threads, order, job.max_set_value, job.subset_size, job.first_rank, job.count, iteration, pass, fail);
+
+        char first_rank_string[RANK_STRING_LENGTH];
+        fprintf(output, "result %u %u %s %llu %llu %llu %.6lf\n", job.max_set_value, job.subset_size, rank_to_string(job.first_rank, first_rank_string), job.count, pass, fail, wall_time() - start);
+        fflush(output);
+    }
+}
+
+/**
+ *  Runs jobs from stdin, or if socket_path isn't empty, from each connection to a Unix socket there (until killed).
+ */
+void run_daemon(const unsigned int number_threads, const subset_order order, const string &socket_path) {
+    subset_tester tester;
+    bool tester_made = false;
+
+#ifdef ENABLE_CHECKPOINTING
+    report_checkpoints = true;
+    start_progress_timer();
+#endif
+
+    if (socket_path.empty()) {
+        serve_jobs(stdin, stdout, tester, tester_made, number_threads, order);
+    } else {
+#ifdef _WIN32
+        fprintf(stderr, "ERROR, --socket is not supported on Windows, use --daemon with stdin.\n");
+        exit(0);
+#else
+        struct sockaddr_un address;
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            fprintf(stderr, "ERROR, the socket path '%s' is too long.\n", socket_path.c_str());
+            exit(0);
+        }
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, socket_path.c_str());
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(socket_path.c_str());
+        if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+            fprintf(stderr, "ERROR: could not listen on '%s'.\n", socket_path.c_str());
+            exit(0);
+        }
+        fprintf(stderr, "listening for jobs on '%s'.\n", socket_path.c_str());
+
+        /**
+         *  A client closing its connection before reading its results shouldn't stop the daemon.
+         */
+        signal(SIGPIPE, SIG_IGN);
+
+        while (true) {
+            int connection = accept(listener, NULL, NULL);
+            if (connection < 0) continue;
+
+            FILE *input = fdopen(connection, "r");
+            FILE *output = fdopen(dup(connection), "w");
+            if (input == NULL || output == NULL) {
+                fprintf(stderr, "ERROR: could not open a connection for jobs.\n");
+                exit(1);
+            }
+
+            serve_jobs(input, output, tester, tester_made, number_threads, order);
+            if (tester_made) flush_results(tester.results);
+            fclose(input);
+            fclose(output);
+        }
+#endif
+    }
+
+    if (tester_made) delete_subset_tester(tester);
+#ifdef ENABLE_CHECKPOINTING
+    stop_progress_timer();
+#endif
+}
+
+int main(int argc, char** argv) {
+#ifdef _BOINC_
+    int retval = 0;
+#ifdef BOINC_APP_GRAPHICS
+#if defined(_WIN32) || defined(__APPLE)
+    retval = boinc_init_graphics(worker);
+#else
+    retval = boinc_init_graphics(worker, argv[0]);
+#endif
+#else
+    retval = boinc_init();
+#endif
+    if (retval) exit(retval);
+#endif
+
+    select_shift_or_kernel();
+    fprintf(stderr, "using the %s shift_or kernel.\n", shift_or_dispatch::kernel_name);
+    init_bit_characters();
+
+    /**
+     *  Take out the --threads, --order, --sweep, --daemon, --socket and interval options, leaving the positional arguments in argv.
+     */
+    unsigned int number_threads = 1;
+    subset_order order = LEXICOGRAPHIC_ORDER;
+    bool sweep = false;
+    bool daemon_mode = false;
+    string socket_path;
+    int positional_arguments = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            number_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--daemon") == 0 || (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)) {
+#if defined(BINARY_OUTPUT) || defined(HTML_OUTPUT) || defined(_BOINC_)
+            fprintf(stderr, "ERROR, %s cannot be used with -DBINARY_OUTPUT, -DHTML_OUTPUT or -D_BOINC_.\n", argv[i]);
+            exit(0);
+#else
+            daemon_mode = true;
+            if (strcmp(argv[i], "--socket") == 0) socket_path = argv[++i];
+#endif
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+#if defined(BINARY_OUTPUT) || defined(HTML_OUTPUT) || defined(_BOINC_)
+            fprintf(stderr, "ERROR, --sweep cannot be used with -DBINARY_OUTPUT, -DHTML_OUTPUT or -D_BOINC_.\n");
+            exit(0);
+#else
+            sweep = true;
+#endif
+        } else if ((strcmp(argv[i], "--progress-interval") == 0 || strcmp(argv[i], "--checkpoint-interval") == 0) && i + 1 < argc) {
+#ifdef ENABLE_CHECKPOINTING
+            double seconds = atof(argv[i + 1]);
+            if (seconds <= 0) {
+                fprintf(stderr, "ERROR, %s must be a number of seconds more than 0.\n", argv[i]);
+                exit(0);
+            }
+            if (strcmp(argv[i], "--progress-interval") == 0)    progress_interval = seconds;
+            else                                                checkpoint_interval = seconds;
+            i++;
+#else
+            fprintf(stderr, "ERROR, %s requires compiling with -DENABLE_CHECKPOINTING.\n", argv[i]);
+            exit(0);
+#endif
+        } else if (strcmp(argv[i], "--order") == 0 && i + 1 < argc) {
+            i++;
+            order = SUBSET_ORDERS;
+            for (unsigned int j = 0; j < SUBSET_ORDERS; j++) {
+                if (strcmp(argv[i], subset_order_names[j]) == 0) order = (subset_order)j;
+            }
+            if (order == SUBSET_ORDERS) {
+                fprintf(stderr, "ERROR, unknown order '%s' (use lexicographic, jun_liu or revolving_door).\n", argv[i]);
+                exit(0);
+            }
+        } else {
+            argv[positional_arguments++] = argv[i];
+        }
+    }
+    argc = positional_arguments;
+
+#ifndef ENABLE_THREADS
+    if (number_threads > 1) {
+        fprintf(stderr, "ERROR, --threads requires compiling with -DENABLE_THREADS.\n");
+        exit(0);
+    }
+#endif
+
+    if (order == REVOLVING_DOOR_ORDER && number_threads > 1) {
+        fprintf(stderr, "ERROR, --order revolving_door can only be used with one thread.\n");
+        exit(0);
+    }
+
+    bool wrong_arguments;
+    if (daemon_mode)    wrong_arguments = (argc != 1 || sweep);
+    else                wrong_arguments = (argc != 3 && argc != 5) || (sweep && argc != 5);
+
+    if (wrong_arguments) {
         fprintf(stderr, "ERROR, wrong command line arguments.\n");
         fprintf(stderr, "USAGE:\n");
-        fprintf(stderr, "\t./subset_sum <M> <N> [<i> <count>]\n\n");
+        fprintf(stderr, "\t./subset_sum [--threads <t>] [--order <o>] [--progress-interval <s>] [--checkpoint-interval <s>] <M> <N> [<i> <count>]\n");
+        fprintf(stderr, "\t./subset_sum [--threads <t>] [--order <o>] --sweep <first M> <last M> <first N> <last N>\n");
+        fprintf(stderr, "\t./subset_sum [--threads <t>] [--order <o>] (--daemon | --socket <path>)\n\n");
         fprintf(stderr, "argumetns:\n");
         fprintf(stderr, "\t<M>      :   The maximum value allowed in the sets.\n");
         fprintf(stderr, "\t<N>      :   The number of elements allowed in a set.\n");
         fprintf(stderr, "\t<i>      :   (optional) start at the <i>th generated subset.\n");
         fprintf(stderr, "\t<count>  :   (optional) only test <count> subsets (starting at the <i>th subset).\n");
+        fprintf(stderr, "\t<t>      :   (optional) split the subsets between <t> threads (requires -DENABLE_THREADS).\n");
+        fprintf(stderr, "\t<o>      :   (optional) the order to test the subsets in, lexicographic (the default), jun_liu or revolving_door.\n");
+        fprintf(stderr, "\t<s>      :   (optional) seconds between progress reports (default 1) or checkpoints (default 10), requires -DENABLE_CHECKPOINTING.\n");
+        fprintf(stderr, "\t--sweep  :   test every <M> from <first M> to <last M> with every <N> from <first N> to <last N> (up to <M>), printing the totals of each.\n");
+        fprintf(stderr, "\t--daemon :   read '<M> <N> [<i> <count>]' jobs from stdin (or with --socket, from connections to a Unix socket at <path>), writing a result line for each.\n");
         exit(0);
     }
 
+    if (daemon_mode) {
+        run_daemon(number_threads, order, socket_path);
+        return 0;
+    }
+
+    if (sweep) {
+        unsigned long first_M = atol(argv[1]), last_M = atol(argv[2]);
+        unsigned long first_N = atol(argv[3]), last_N = atol(argv[4]);
+
+        if (first_N == 0 || first_M > last_M || first_N > last_N || last_M < first_N) {
+            fprintf(stderr, "ERROR, --sweep needs 1 <= <first N> <= <last N>, <first M> <= <last M> and <first N> <= <last M>.\n");
+            exit(0);
+        }
+
+        output_target = stdout;
+        test_sweep(number_threads, order, first_M, last_M, first_N, last_N);
+        return 0;
+    }
+
     unsigned long max_set_value = atol(argv[1]);
-#ifdef HTML_OUTPUT
-    max_set_digits = ceil(log10(max_set_value)) + 1;
-#endif
 
     unsigned long subset_size = atol(argv[2]);
 
@@ -587,7 +2040,8 @@ int main(int argc, char** argv) {
     unsigned long long fail = 0;
 
 #ifdef ENABLE_CHECKPOINTING
-    bool started_from_checkpoint = read_checkpoint(checkpoint_file, iteration, pass, fail);
+    output_position checkpoint_output;
+    bool started_from_checkpoint = read_checkpoint(checkpoint_file, iteration, pass, fail, checkpoint_output);
 #else
     bool started_from_checkpoint = false;
 #endif
@@ -600,50 +2054,39 @@ int main(int argc, char** argv) {
         exit(0);
     }   
 
+    /**
+     *  The output is opened for reading as well, so its digest can be checked (see restore_output).
+     */
+#ifdef BINARY_OUTPUT
+    if (started_from_checkpoint) {
+        output_target = fopen(output_path.c_str(), "a+b");
+    } else {
+        output_target = fopen(output_path.c_str(), "w+b");
+    }
+#else
     if (started_from_checkpoint) {
-        output_target = fopen(output_path.c_str(), "a");
+        output_target = fopen(output_path.c_str(), "a+");
     } else {
-        output_target = fopen(output_path.c_str(), "w");
+        output_target = fopen(output_path.c_str(), "w+");
     }
+#endif
 #else 
     output_target = stdout;
 #endif
 
-#ifdef HTML_OUTPUT
-    fprintf(output_target, "<!DOCTYPE html PUBLIC \"-//w3c//dtd html 4.0 transitional//en\">\n");
-    fprintf(output_target, "<html>\n");
-    fprintf(output_target, "<head>\n");
-    fprintf(output_target, "  <meta http-equiv=\"Content-Type\"\n");
-    fprintf(output_target, " content=\"text/html; charset=iso-8859-1\">\n");
-    fprintf(output_target, "  <meta name=\"GENERATOR\"\n");
-    fprintf(output_target, " content=\"Mozilla/4.76 [en] (X11; U; Linux 2.4.2-2 i686) [Netscape]\">\n");
-    fprintf(output_target, "  <title>%lu choose %lu</title>\n", max_set_value, subset_size);
-    fprintf(output_target, "\n");
-    fprintf(output_target, "<style type=\"text/css\">\n");
-    fprintf(output_target, "    .courier_green {\n");
-    fprintf(output_target, "        color: #008000;\n");
-    fprintf(output_target, "    }   \n");
-    fprintf(output_target, "</style>\n");
-    fprintf(output_target, "<style type=\"text/css\">\n");
-    fprintf(output_target, "    .courier_red {\n");
-    fprintf(output_target, "        color: #FF0000;\n");
-    fprintf(output_target, "    }   \n");
-    fprintf(output_target, "</style>\n");
-    fprintf(output_target, "\n");
-    fprintf(output_target, "</head><body>\n");
-    fprintf(output_target, "<h1>%lu choose %lu</h1>\n", max_set_value, subset_size);
-    fprintf(output_target, "<hr width=\"100%%\">\n");
-    fprintf(output_target, "\n");
-    fprintf(output_target, "<br>\n");
-    fprintf(output_target, "<tt>\n");
+#ifdef ENABLE_CHECKPOINTING
+    if (started_from_checkpoint && !restore_output(output_target, checkpoint_output)) {
+        fprintf(stderr, "The output does not match the checkpoint, starting over.\n");
+        started_from_checkpoint = false;
+        iteration = pass = fail = 0;
+    }
 #endif
 
-    if (!started_from_checkpoint) {
-#ifndef HTML_OUTPUT
-        fprintf(output_target, "max_set_value: %lu, subset_size: %lu\n", max_set_value, subset_size);
-#else
-        fprintf(output_target, "max_set_value: %lu, subset_size: %lu<br>\n", max_set_value, subset_size);
+#ifndef BINARY_OUTPUT
+    print_report_start(output_target, max_set_value, subset_size, started_from_checkpoint);
 #endif
+
+    if (!started_from_checkpoint) {
         if (max_set_value < subset_size) {
             fprintf(stderr, "Error max_set_value < subset_size. Quitting.\n");
             exit(0);
@@ -653,7 +2096,7 @@ int main(int argc, char** argv) {
     }
 
     //timestamp flag
-#ifdef TIMESTAMP
+#if defined(TIMESTAMP) && !defined(BINARY_OUTPUT)
     time_t start_time;
     time( &start_time );
     if (!started_from_checkpoint) {
@@ -662,34 +2105,20 @@ int main(int argc, char** argv) {
 #endif
 
     bool doing_slice = false;
-    unsigned int starting_subset = 0;
-    unsigned int subsets_to_calculate = 0;
+    subset_rank_t starting_subset = 0;
+    subset_rank_t subsets_to_calculate = 0;
 
     if (argc == 5) {
         doing_slice = true;
-        starting_subset = atoi(argv[3]);
-        subsets_to_calculate = atoi(argv[4]);
+        if (!parse_rank(argv[3], starting_subset) || !parse_rank(argv[4], subsets_to_calculate)) {
+            fprintf(stderr, "ERROR, <i> and <count> must be whole numbers less than 2^%u.\n", RANK_BITS);
+            exit(0);
+        }
     }
 
-    /**
-     *  Calculate the maximum set length (in bits) so we can use this for printing out the values cleanly.
-     */
-    unsigned int *max_set = new unsigned int[subset_size];
-    for (unsigned int i = 0; i < subset_size; i++) max_set[subset_size - i - 1] = max_set_value - i;
-    for (unsigned int i = 0; i < subset_size; i++) max_sums_length += max_set[i];
-
-//    sums_length /= 2;
-    max_sums_length /= ELEMENT_SIZE;
-    max_sums_length++;
-
-    delete [] max_set;
-
-    unsigned int *subset = new unsigned int[subset_size];
-#ifdef NEXT_SUBSET_JUN_LIU
-    unsigned int *bubbles = new unsigned int[subset_size + 1];
-    bubbles[0] = max_set_value - subset_size;
-    for (unsigned int i = 1; i <= subset_size; i++) bubbles[i] = 0;
-#endif
+    if (set_sums_lengths(max_set_value, subset_size) != test_sums_generic) {
+        fprintf(stderr, "using the specialized sums kernel for %lu elements and a subset size of %lu.\n", max_sums_length, subset_size);
+    }
 
 //    this caused a problem:
 //    
@@ -698,11 +2127,29 @@ int main(int argc, char** argv) {
 //    print_subset(subset, subset_size);
 //    fprintf(output_target, "\n");
 
-    unsigned long long expected_total = n_choose_k(max_set_value - 1, subset_size - 1);
+    if (subset_size == 0) {
+        fprintf(stderr, "Error subset_size must be at least 1. Quitting.\n");
+        exit(0);
+    }
 
-#ifdef HTML_OUTPUT
-    max_digits = ceil(log10(expected_total));
-#endif
+    if (order == REVOLVING_DOOR_ORDER && subset_size - 1 > MAX_COUNTED_ELEMENTS) {
+        fprintf(stderr, "Error --order revolving_door only works with subset sizes up to %u. Quitting.\n", MAX_COUNTED_ELEMENTS + 1);
+        exit(0);
+    }
+
+    init_binomials(max_set_value - 1, subset_size - 1);
+    subset_rank_t expected_total = n_choose_k(max_set_value - 1, subset_size - 1);
+    if (expected_total == MAX_RANK) {
+        fprintf(stderr, "Error there are too many subsets to rank (2^%u or more). Quitting.\n", RANK_BITS);
+        exit(0);
+    }
+
+    char expected_total_string[RANK_STRING_LENGTH];
+    char subsets_to_calculate_string[RANK_STRING_LENGTH];
+    rank_to_string(expected_total, expected_total_string);
+    rank_to_string(subsets_to_calculate, subsets_to_calculate_string);
+
+    init_report_widths(max_set_value, expected_total);
 
 //    for (unsigned long long i = 0; i < expected_total; i++) {
 //        fprintf(output_target, "%15llu ", i);
@@ -712,102 +2159,127 @@ int main(int argc, char** argv) {
 //    }
 
 
-#ifndef HTML_OUTPUT
-    if (!started_from_checkpoint) {
-        if (doing_slice) {
-            fprintf(output_target, "performing %u set evaluations.\n", subsets_to_calculate);
-        } else {
-            fprintf(output_target, "performing %llu set evaluations.\n", expected_total);
-        }
-    }
-#else
-    if (!started_from_checkpoint) {
-        if (doing_slice) {
-            fprintf(output_target, "performing %u set evaluations.<br>\n", subsets_to_calculate);
-        } else {
-            fprintf(output_target, "performing %llu set evaluations.<br>\n", expected_total);
-        }
-    }
+#ifndef BINARY_OUTPUT
+    if (!started_from_checkpoint) print_report_evaluations(output_target, doing_slice ? subsets_to_calculate_string : expected_total_string);
 #endif
 
-    if (started_from_checkpoint) {
-        if (iteration >= expected_total) {
-            fprintf(stderr, "starting subset [%u] > total subsets [%llu]\n", starting_subset, expected_total);
-            fprintf(stderr, "quitting.\n");
-            exit(0);
-        }
-        generate_ith_subset(iteration, subset, subset_size, max_set_value);
-    } else if (doing_slice) {
+    /**
+     *  Test the subsets ranked first_rank to first_rank + subsets_in_run - 1.  iteration is how many of these have
+     *  already been tested (when starting from a checkpoint).
+     */
+    subset_rank_t first_rank = 0;
+    subset_rank_t subsets_to_test = expected_total;
+
+    if (doing_slice) {
         if (starting_subset >= expected_total) {
-            fprintf(stderr, "starting subset [%u] > total subsets [%llu]\n", starting_subset, expected_total);
+            char starting_subset_string[RANK_STRING_LENGTH];
+            fprintf(stderr, "starting subset [%s] > total subsets [%s]\n", rank_to_string(starting_subset, starting_subset_string), expected_total_string);
             fprintf(stderr, "quitting.\n");
             exit(0);
         }
-        generate_ith_subset(starting_subset, subset, subset_size, max_set_value);
-    } else {
-        for (unsigned int i = 0; i < subset_size - 1; i++) subset[i] = i + 1;
-        subset[subset_size - 1] = max_set_value;
+        first_rank = starting_subset;
+        subsets_to_test = subsets_to_calculate;
+        if (subsets_to_test > expected_total - first_rank) subsets_to_test = expected_total - first_rank;
     }
 
-    sums = new unsigned int[max_sums_length];
-    new_sums = new unsigned int[max_sums_length];
+    if (subsets_to_test > ULLONG_MAX) {
+        fprintf(stderr, "cannot test more than %llu subsets in one run, use <i> and <count> to test a slice.\n", ULLONG_MAX);
+        fprintf(stderr, "quitting.\n");
+        exit(0);
+    }
+    unsigned long long subsets_in_run = (unsigned long long)subsets_to_test;
 
-    bool success;
+    if (iteration > subsets_in_run) {
+        fprintf(stderr, "checkpoint iteration [%llu] > subsets to test [%llu]\n", iteration, subsets_in_run);
+        fprintf(stderr, "quitting.\n");
+        exit(0);
+    }
 
-#ifdef _BOINC_
+#ifdef ENUMERATION_BENCHMARK
+    benchmark_enumerators(max_set_value, subset_size, first_rank, subsets_in_run);
+    return 0;
+#endif
+
+#ifdef KERNEL_BENCHMARK
+    benchmark_kernels(max_set_value, subset_size, first_rank, subsets_in_run);
+    return 0;
+#endif
+
+#ifdef BINARY_OUTPUT
+    records_first_rank = first_rank;
+    if (!started_from_checkpoint) {
+        failed_set_header header;
+        header.flags = 0;
+        if (doing_slice) header.flags |= FAILED_SET_SLICE;
+#ifndef NO_MISSING_SUMS
+        header.flags |= FAILED_SET_MISSING_SUMS;
+#endif
+#ifdef FULL_RANGE_SUMS
+        header.flags |= FAILED_SET_FULL_RANGE;
+#endif
+        header.order = order;
+        header.max_set_value = max_set_value;
+        header.subset_size = subset_size;
+        header.first_rank = first_rank;
+        header.count = subsets_to_calculate;
+
+        write_failed_set_header(output_target, header);
+        fflush(output_target);
+    }
+#elif defined(_BOINC_)
     if (!started_from_checkpoint) {
         fprintf(output_target, "<tested_subsets>\n");
         fflush(output_target);
     }
 #endif
 
-#ifndef NEXT_SUBSET_JUN_LIU
-    while (subset[0] <= (max_set_value - subset_size + 1)) {
-#else
-    while (bubbles[0] > 0 || bubbles[subset_size] < (max_set_value - subset_size)) {
+#ifdef RUN_STATS
+    init_stats_clock();
+    start_hardware_counters();
+
+    run_totals totals;
+    totals.max_set_value = max_set_value;
+    totals.subset_size = subset_size;
+    totals.sweep = false;
+    totals.first_set_value = max_set_value;
+    totals.first_subset_size = subset_size;
+    totals.pairs = 1;
+    totals.order = order;
+    totals.threads = number_threads;
+    totals.subsets = subsets_in_run - iteration;
+
+    double stats_start = stats_time();
+    clock_t stats_cpu_start = clock();
 #endif
-        success = test_subset(subset, subset_size, iteration, starting_subset, doing_slice);
 
-        if (success)    pass++;
-        else            fail++;
-
-#ifndef NEXT_SUBSET_JUN_LIU
-        generate_next_subset_td(subset, subset_size, max_set_value);
-#else
-        generate_next_subset_jl(subset, subset_size, max_set_value, bubbles);
+#ifdef ENABLE_CHECKPOINTING
+    start_progress_timer();
 #endif
 
-        if (doing_slice && iteration >= subsets_to_calculate) break;
+    subset_tester tester;
+    new_subset_tester(tester, max_set_value, subset_size, output_target);
+    test_run(tester, number_threads, order, max_set_value, subset_size, first_rank, subsets_in_run, iteration, pass, fail);
+    delete_subset_tester(tester);
 
 #ifdef ENABLE_CHECKPOINTING
-        /**
-         *  Need to checkpoint if we found a failed set, otherwise the output file might contain duplicates
-         */
-        if (!success || (iteration % 10000) == 0) {
-            double progress;
-            if (doing_slice) {
-                progress = (double)iteration / (double)subsets_to_calculate;
-            } else {
-                progress = (double)iteration / (double)expected_total;
-           }
-#ifdef _BOINC_
-            boinc_fraction_done(progress);
+    stop_progress_timer();
 #endif
-//            printf("\r%lf", progress);
 
-            if (!success || (iteration % 60000000) == 0) {      //this works out to be a checkpoint every 10 seconds or so
-//                fprintf(stderr, "\n*****Checkpointing! *****\n");
-                write_checkpoint(checkpoint_file, iteration, pass, fail);    
-#ifdef _BOINC_
-                boinc_checkpoint_completed();
-#endif
-            }
-        }
-#endif
+#ifdef RUN_STATS
+    add_thread_stats();
 
-        iteration++;
-    }
+    totals.pass = pass;
+    totals.fail = fail;
+    totals.wall_seconds = stats_time() - stats_start;
+    totals.cpu_seconds = (double)(clock() - stats_cpu_start) / CLOCKS_PER_SEC;
+    write_run_stats(run_stats_file, totals);
+#endif
 
+#ifdef BINARY_OUTPUT
+    write_failed_set_end(output_target, pass, fail);
+    fflush(output_target);
+    print_report_totals(stderr, doing_slice, subsets_to_calculate_string, expected_total_string, pass, fail);
+#else
 #ifdef _BOINC_
     fprintf(output_target, "</tested_subsets>\n");
     fprintf(output_target, "<extra_info>\n");
@@ -816,32 +2288,23 @@ int main(int argc, char** argv) {
     /**
      * pass + fail should = M! / (N! * (M - N)!)
      */
+    print_report_totals(output_target, doing_slice, subsets_to_calculate_string, expected_total_string, pass, fail);
+#endif
 
-#ifndef HTML_OUTPUT
-    if (doing_slice) {
-        fprintf(output_target, "expected to compute %u sets\n", subsets_to_calculate);
-    } else {
-        fprintf(output_target, "the expected total number of sets is: %llu\n", expected_total);
-    }
-    fprintf(output_target, "%llu total sets, %llu sets passed, %llu sets failed, %lf success rate.\n", pass + fail, pass, fail, ((double)pass / ((double)pass + (double)fail)));
-#else
-    if (doing_slice) {
-        fprintf(output_target, "expected to compute %u sets<br>\n", subsets_to_calculate);
-    } else {
-        fprintf(output_target, "the expected total number of sets is: %llu<br>\n", expected_total);
-    }
-    fprintf(output_target, "%llu total sets, %llu sets passed, %llu sets failed, %lf success rate.<br>\n", pass + fail, pass, fail, ((double)pass / ((double)pass + (double)fail)));
+#ifndef NO_ACCEPT_FILTER
+    fprintf(stderr, "accept filters: %llu empty range, %llu contiguous sums, %llu tested with the sums bitsets.\n", accept_filter_counts[ACCEPT_EMPTY_RANGE], accept_filter_counts[ACCEPT_CONTIGUOUS_SUMS], accept_filter_counts[ACCEPT_NONE]);
 #endif
 
-#ifdef _BOINC_
+#if defined(_BOINC_) && !defined(BINARY_OUTPUT)
+#if defined(RUN_STATS) && defined(RUN_STATS_EXTRA_INFO)
+    fprintf(output_target, "<run_stats>\n");
+    print_run_stats(output_target, totals);
+    fprintf(output_target, "</run_stats>\n");
+#endif
     fprintf(output_target, "</extra_info>\n");
 #endif
 
-    delete [] subset;
-    delete [] sums;
-    delete [] new_sums;
-
-#ifdef TIMESTAMP
+#if defined(TIMESTAMP) && !defined(BINARY_OUTPUT)
     time_t end_time;
     time( &end_time );
     fprintf(output_target, "end time: %s", ctime(&end_time) );
@@ -852,15 +2315,11 @@ int main(int argc, char** argv) {
     boinc_finish(0);
 #endif
 
-#ifdef HTML_OUTPUT
-    fprintf(output_target, "</tt>\n");
-    fprintf(output_target, "<br>\n");
-    fprintf(output_target, "\n");
-    fprintf(output_target, "<hr width=\"100%%\">\n");
-    fprintf(output_target, "Copyright &copy; Travis Desell, Tom O'Neil and the University of North Dakota, 2012\n");
-    fprintf(output_target, "</body>\n");
-    fprintf(output_target, "</html>\n");
+#ifndef BINARY_OUTPUT
+    print_report_end(output_target);
+#endif
 
+#ifdef HTML_OUTPUT
     if (fail > 0) {
         fprintf(stderr, "[url=http://volunteer.cs.und.edu/subset_sum/download/set_%luc%lu.html]%lu choose %lu[/url] -- %llu failures\n", max_set_value, subset_size, max_set_value, subset_size, fail);
     } else {
@@ -0,0 +1,210 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include "sss_slices.hpp"
+#include "sss_jobs.hpp"
+
+/**
+ *  Times making the jobs of a slice plan with the batching sss_work_generator uses (make_job_batch, see sss_jobs.hpp),
+ *  against a SQLite database standing in for the BOINC MySQL database (so it can be run without a BOINC server), and
+ *  prints the jobs per second, eg:
+ *
+ *      g++ -Wall -O2 benchmark_job_creation.cpp -o benchmark_job_creation -lsqlite3
+ *      ./benchmark_job_creation jobs.db download 5000 1 100 1000
+ *
+ *  With a batch size of 1, each job writes its input file and inserts its workunit in a transaction of its own, as
+ *  sss_work_generator did before it made jobs in batches.  Otherwise the input files of a batch are all written
+ *  first, then its workunits are inserted INSERT_ROWS at a time in one transaction.  The workunit table has the
+ *  columns and indexes of the BOINC one that an insert touches, and the rows have an xml_doc like the ones
+ *  create_work makes, so each insert writes about as much as it would on the server.  SQLite syncs each commit to
+ *  disk, as MySQL does by default (innodb_flush_log_at_trx_commit = 1), which is most of the cost of a commit.
+ */
+const char *WORKUNIT_TABLE =
+    "create table workunit ("
+    "id integer primary key autoincrement, create_time integer not null, appid integer not null, "
+    "name varchar(254) not null unique, xml_doc blob, batch integer not null, "
+    "rsc_fpops_est double not null, rsc_fpops_bound double not null, rsc_memory_bound double not null, "
+    "rsc_disk_bound double not null, need_validate smallint not null, canonical_resultid integer not null, "
+    "canonical_credit double not null, transition_time integer not null, delay_bound integer not null, "
+    "error_mask integer not null, file_delete_state integer not null, assimilate_state integer not null, "
+    "hr_class integer not null, opaque double not null, min_quorum integer not null, "
+    "target_nresults integer not null, max_error_results integer not null, max_total_results integer not null, "
+    "max_success_results integer not null, result_template_file varchar(63) not null, priority integer not null, "
+    "mod_time timestamp default current_timestamp, rsc_bandwidth_bound double not null, fileset_id integer not null, "
+    "app_version_id integer not null, transitioner_flags tinyint not null, size_class smallint not null, "
+    "keywords varchar(254) not null, app_version_num integer not null);"
+    "create index wu_val on workunit(appid, need_validate);"
+    "create index wu_timeout on workunit(transition_time);"
+    "create index wu_assim on workunit(appid, assimilate_state);"
+    "create index wu_filedel on workunit(file_delete_state);";
+
+static double now() {
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + (time.tv_usec / 1e6);
+}
+
+static int exec_sql(sqlite3 *database, const char *sql) {
+    char *message = NULL;
+    if (sqlite3_exec(database, sql, NULL, NULL, &message) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: '%.60s...' failed: %s\n", sql, message);
+        sqlite3_free(message);
+        return 1;
+    }
+    return 0;
+}
+
+static void run_sql(sqlite3 *database, const char *sql) {
+    if (exec_sql(database, sql)) exit(1);
+}
+
+/**
+ *  Writes the input file of a slice to the download directory, and adds its workunit's row to values.
+ */
+static void make_job(const char *download_dir, const slice_plan &plan, const subset_rank_t first_rank, std::string &values) {
+    char name[256], path[1024], arguments[256], row[4096];
+
+    subset_rank_t count = slice_count(plan, first_rank);
+    slice_name("subset_sum", plan, first_rank, count, name);
+    slice_arguments(plan, first_rank, count, arguments);
+
+    sprintf(path, "%s/%s", download_dir, name);
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: could not write '%s'.\n", path);
+        exit(1);
+    }
+    fprintf(file, "%s\n", arguments);
+    fclose(file);
+
+    double fpops = slice_fpops(plan, count, 3e9);
+    sprintf(row,
+        "(null, strftime('%%s', 'now'), 1, '%s', "
+        "'<file_info>\n    <name>%s</name>\n    <url>http://localhost/download/%s</url>\n    <md5_cksum>d41d8cd98f00b204e9800998ecf8427e</md5_cksum>\n    <nbytes>%u</nbytes>\n</file_info>\n"
+        "<workunit>\n    <file_ref>\n        <file_name>%s</file_name>\n        <open_name>in</open_name>\n    </file_ref>\n"
+        "    <command_line>%s</command_line>\n    <rsc_fpops_est>%f</rsc_fpops_est>\n    <rsc_fpops_bound>%f</rsc_fpops_bound>\n"
+        "    <rsc_memory_bound>100000000.000000</rsc_memory_bound>\n    <rsc_disk_bound>100000000.000000</rsc_disk_bound>\n</workunit>\n', "
+        "0, %f, %f, 1e8, 1e8, 0, 0, 0, strftime('%%s', 'now'), 86400, 0, 0, 0, 0, 0, 1, 1, 4, 8, 4, "
+        "'templates/subset_sum_out.xml', 0, current_timestamp, 0, 0, 0, 0, -1, '', 0)",
+        name, name, name, (unsigned int)strlen(arguments) + 1, name, arguments, fpops, fpops * FPOPS_BOUND_FACTOR, fpops, fpops * FPOPS_BOUND_FACTOR
+    );
+
+    if (!values.empty()) values += ",";
+    values += row;
+}
+
+/**
+ *  The SQLite database, for make_job_batch.
+ */
+struct sqlite_jobs {
+    sqlite3 *database;
+    const char *download_dir;
+    const slice_plan *plan;
+
+    int make_job(const subset_rank_t first_rank, std::string &values) {
+        ::make_job(download_dir, *plan, first_rank, values);
+        return 0;
+    }
+
+    int start_transaction() {
+        return exec_sql(database, "begin");
+    }
+
+    int insert_batch(std::string &values) {
+        std::string sql = "insert into workunit values " + values;
+        return exec_sql(database, sql.c_str());
+    }
+
+    int commit_transaction() {
+        return exec_sql(database, "commit");
+    }
+
+    int rollback_transaction() {
+        return exec_sql(database, "rollback");
+    }
+};
+
+/**
+ *  Makes every slice of the plan, batch_size jobs at a time, and returns how many seconds it took.
+ */
+static double make_jobs(sqlite_jobs &database, const slice_plan &plan, const unsigned int njobs, const unsigned int batch_size) {
+    double start = now();
+    subset_rank_t first_rank = 0;
+
+    for (unsigned int made = 0; made < njobs; ) {
+        unsigned int batch = (njobs - made < batch_size) ? njobs - made : batch_size;
+        if (make_job_batch(database, plan, first_rank, batch)) {
+            fprintf(stderr, "ERROR: could not make the jobs.\n");
+            exit(1);
+        }
+        made += batch;
+    }
+
+    return now() - start;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        fprintf(stderr, "USAGE:\n");
+        fprintf(stderr, "\t./benchmark_job_creation <database> <download dir> <jobs> <batch size>...\n\n");
+        fprintf(stderr, "\t<database>      :   the SQLite database to make (it is deleted first).\n");
+        fprintf(stderr, "\t<download dir>  :   where to write the input files (which must exist).\n");
+        fprintf(stderr, "\t<jobs>          :   how many jobs to make with each batch size.\n");
+        fprintf(stderr, "\t<batch size>    :   jobs made in each transaction (1 for a job at a time).\n");
+        exit(0);
+    }
+
+    const char *database_file = argv[1];
+    const char *download_dir = argv[2];
+    unsigned int jobs = atoi(argv[3]);
+
+    /**
+     *  Slices of a problem big enough for any number of jobs, so every job has its own name.
+     */
+    const char *error;
+    slice_plan plan;
+    throughput_model model;
+    init_binomials(1000 - 1, 10 - 1);
+    if (jobs == 0 || !plan_slices(model, 1000, 10, 1, plan, error)) {
+        fprintf(stderr, "ERROR: could not plan the slices.\n");
+        exit(0);
+    }
+
+    printf("batch_size\tjobs\tseconds\tjobs_per_second\n");
+    for (int i = 4; i < argc; i++) {
+        unsigned int batch_size = atoi(argv[i]);
+        if (batch_size == 0) {
+            fprintf(stderr, "ERROR: the batch size must be more than 0.\n");
+            exit(0);
+        }
+
+        sqlite3 *database;
+        remove(database_file);
+        if (sqlite3_open(database_file, &database) != SQLITE_OK) {
+            fprintf(stderr, "ERROR: could not open '%s'.\n", database_file);
+            exit(1);
+        }
+        run_sql(database, WORKUNIT_TABLE);
+
+        sqlite_jobs batches;
+        batches.database = database;
+        batches.download_dir = download_dir;
+        batches.plan = &plan;
+
+        double seconds = make_jobs(batches, plan, jobs, batch_size);
+        printf("%u\t%u\t%.3f\t%.0f\n", batch_size, jobs, seconds, jobs / seconds);
+        fflush(stdout);
+
+        sqlite3_close(database);
+    }
+
+    remove(database_file);
+    return 0;
+}
@@ -0,0 +1,383 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <vector>
+#include <deque>
+#include <map>
+
+#include "sss_slices.hpp"
+#include "sss_stragglers.hpp"
+
+using namespace std;
+
+/**
+ *  Simulates hosts working through the slices of a problem, to measure how much sooner it finishes when late slices
+ *  are split (see sss_stragglers.hpp) than when they are left to finish (or be handed out again at their deadline),
+ *  eg:
+ *
+ *      g++ -Wall -O2 simulate_stragglers.cpp -o simulate_stragglers
+ *      ./simulate_stragglers --hosts 100 --slices 2000 --runs 10
+ *
+ *  Each host has a speed (a typical host tests TYPICAL_RATE subsets per second, and the rest are spread around that
+ *  with a lognormal of --spread), --slow_fraction of them are --slow_factor times slower again (eg busy with other
+ *  work), and --quit_fraction of them stop for good at a random time (eg they were turned off).  Every slice takes
+ *  --slice_seconds on a typical host.  Hosts checkpoint every --checkpoint_interval seconds, and a slice not finished
+ *  --deadline seconds after it was handed out is handed out again (as BOINC does at a workunit's delay bound), with
+ *  whichever copy finishes first counting.  Idle hosts take a slice handed out again first, then the next new one.
+ *
+ *  Both policies are run on the same hosts for each run (with its own seed), and the time each took to finish every
+ *  subset is printed with the gain, along with the ideal time (all the work spread over all the hosts which never
+ *  quit), as tab separated values.
+ */
+const double TYPICAL_RATE = 1e6;
+
+struct sim_options {
+    unsigned int hosts;
+    unsigned int slices;
+    double slice_seconds;
+    double checkpoint_interval;
+    double deadline;
+    double spread;
+    double slow_fraction;
+    double slow_factor;
+    double quit_fraction;
+};
+
+struct sim_host {
+    double rate;
+    double quit_time;           // when it stops for good (HUGE_VAL if never)
+
+    bool busy;
+    subset_rank_t first_rank;
+    subset_rank_t count;
+    double start;
+    unsigned int splits;        // how many times the slice its piece is part of has been split
+    bool handed_out_again;      // its piece has passed its deadline and been handed out again
+
+    subset_rank_t tested;       // finished subsets, and how long they took
+    double busy_seconds;
+};
+
+struct sim_piece {
+    subset_rank_t first_rank;
+    subset_rank_t count;
+    unsigned int splits;
+};
+
+/**
+ *  A small generator of its own, so runs are the same everywhere for a seed.
+ */
+static unsigned long long sim_seed;
+
+static double sim_random() {
+    sim_seed ^= sim_seed << 13;
+    sim_seed ^= sim_seed >> 7;
+    sim_seed ^= sim_seed << 17;
+    return ((sim_seed >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double sim_normal() {
+    return sqrt(-2 * log(sim_random())) * cos(2 * M_PI * sim_random());
+}
+
+static void make_hosts(const sim_options &options, const double horizon, vector<sim_host> &hosts) {
+    hosts.resize(options.hosts);
+    for (unsigned int i = 0; i < options.hosts; i++) {
+        sim_host &host = hosts[i];
+        host.rate = TYPICAL_RATE * exp(options.spread * sim_normal());
+        if (sim_random() < options.slow_fraction) host.rate /= options.slow_factor;
+        host.quit_time = (sim_random() < options.quit_fraction) ? sim_random() * horizon : HUGE_VAL;
+    }
+}
+
+/**
+ *  The subsets covered by finished pieces, as ranges (first rank to end) which don't touch.
+ */
+struct coverage {
+    map<subset_rank_t, subset_rank_t> ranges;
+    subset_rank_t covered;
+};
+
+static void cover(coverage &done, subset_rank_t first, subset_rank_t end) {
+    map<subset_rank_t, subset_rank_t>::iterator next = done.ranges.upper_bound(first);
+    if (next != done.ranges.begin()) {
+        map<subset_rank_t, subset_rank_t>::iterator before = next;
+        before--;
+        if (before->second >= first) {
+            if (before->second >= end) return;
+            first = before->first;
+            done.covered -= before->second - before->first;
+            done.ranges.erase(before);
+        }
+    }
+    while (next != done.ranges.end() && next->first <= end) {
+        if (next->second > end) end = next->second;
+        done.covered -= next->second - next->first;
+        done.ranges.erase(next++);
+    }
+    done.ranges[first] = end;
+    done.covered += end - first;
+}
+
+/**
+ *  When the host's piece will be finished, or HUGE_VAL if it quits first.
+ */
+static double finish_time(const sim_host &host) {
+    double finish = host.start + ((double)host.count / host.rate);
+    return (finish <= host.quit_time) ? finish : HUGE_VAL;
+}
+
+/**
+ *  The subsets of its piece the host had tested at its last checkpoint before now.
+ */
+static subset_rank_t checkpointed(const sim_host &host, const sim_options &options, const double now) {
+    double worked = ((now < host.quit_time) ? now : host.quit_time) - host.start;
+    if (worked <= 0) return 0;
+
+    double done = floor(worked / options.checkpoint_interval) * options.checkpoint_interval * host.rate;
+    return (done >= (double)host.count) ? host.count : (subset_rank_t)done;
+}
+
+static void start_piece(sim_host &host, const sim_piece &piece, const double now) {
+    host.busy = true;
+    host.first_rank = piece.first_rank;
+    host.count = piece.count;
+    host.start = now;
+    host.splits = piece.splits;
+    host.handed_out_again = false;
+}
+
+/**
+ *  Splits a late piece between the idle hosts, as split_late_piece in sss_coordinator does.  Returns true if one was
+ *  split.
+ */
+static bool split_late_piece(vector<sim_host> &hosts, const sim_options &options, coverage &done, const double now) {
+    double rates = 0;
+    unsigned int measured = 0;
+    vector<unsigned int> helpers;
+    for (unsigned int i = 0; i < hosts.size(); i++) {
+        if (!hosts[i].busy && now < hosts[i].quit_time) helpers.push_back(i);
+        if (hosts[i].tested > 0) {
+            rates += (double)hosts[i].tested / hosts[i].busy_seconds;
+            measured++;
+        }
+    }
+    if (helpers.empty() || measured == 0) return false;
+    double typical_rate = rates / measured;
+
+    vector<double> helper_rates;
+    for (unsigned int i = 0; i < helpers.size(); i++) {
+        const sim_host &helper = hosts[helpers[i]];
+        helper_rates.push_back((helper.tested > 0) ? (double)helper.tested / helper.busy_seconds : typical_rate);
+    }
+
+    for (unsigned int i = 0; i < hosts.size(); i++) {
+        sim_host &host = hosts[i];
+        if (!host.busy || host.splits >= MAX_SPLITS) continue;
+
+        double elapsed = now - host.start;
+        subset_rank_t tested = checkpointed(host, options, now);
+        if (!slice_is_late(host.count, tested, elapsed, typical_rate)) continue;
+
+        vector<subset_rank_t> counts;
+        if (!plan_split(host.count - tested, slice_rate(tested, elapsed), typical_rate, helper_rates, counts)) continue;
+
+        if (tested > 0) cover(done, host.first_rank, host.first_rank + tested);
+
+        sim_piece piece;
+        piece.first_rank = host.first_rank + tested;
+        piece.splits = host.splits + 1;
+        for (unsigned int j = 0; j < counts.size(); j++) {
+            piece.count = counts[j];
+            start_piece(hosts[helpers[j]], piece, now);
+            piece.first_rank += counts[j];
+        }
+
+        host.busy = false;
+        host.tested += tested;
+        host.busy_seconds += elapsed;
+        return true;
+    }
+    return false;
+}
+
+/**
+ *  Runs the problem on the hosts, and returns how long it took to finish every subset (or HUGE_VAL if it didn't
+ *  finish by horizon).  splits is set to how many late pieces were split.
+ */
+static double simulate(vector<sim_host> hosts, const sim_options &options, const bool split, const double horizon, unsigned int &splits) {
+    slice_plan plan;
+    plan.max_set_value = 0;
+    plan.subset_size = 0;
+    plan.slice_size = (subset_rank_t)(options.slice_seconds * TYPICAL_RATE);
+    plan.slices = options.slices;
+    plan.total = plan.slice_size * plan.slices;
+    plan.subsets_per_second = TYPICAL_RATE;
+
+    for (unsigned int i = 0; i < hosts.size(); i++) {
+        hosts[i].busy = false;
+        hosts[i].tested = 0;
+        hosts[i].busy_seconds = 0;
+    }
+
+    coverage done;
+    done.covered = 0;
+    deque<sim_piece> handed_out_again;
+    subset_rank_t next_slice = 0;
+    double now = 0;
+    splits = 0;
+
+    while (done.covered < plan.total) {
+        /**
+         *  Finished pieces, and pieces past their deadline.
+         */
+        for (unsigned int i = 0; i < hosts.size(); i++) {
+            sim_host &host = hosts[i];
+            if (!host.busy) continue;
+
+            if (finish_time(host) <= now) {
+                cover(done, host.first_rank, host.first_rank + host.count);
+                host.busy = false;
+                host.tested += host.count;
+                host.busy_seconds += (double)host.count / host.rate;
+            } else if (!host.handed_out_again && now >= host.start + options.deadline) {
+                sim_piece piece = { host.first_rank, host.count, host.splits };
+                handed_out_again.push_back(piece);
+                host.handed_out_again = true;
+            }
+        }
+        if (done.covered == plan.total) break;
+
+        for (unsigned int i = 0; i < hosts.size(); i++) {
+            sim_host &host = hosts[i];
+            if (host.busy || now >= host.quit_time) continue;
+
+            sim_piece piece;
+            if (!handed_out_again.empty()) {
+                piece = handed_out_again.front();
+                handed_out_again.pop_front();
+            } else if (next_slice < plan.slices) {
+                piece.first_rank = next_slice * plan.slice_size;
+                piece.count = slice_count(plan, piece.first_rank);
+                piece.splits = 0;
+                next_slice++;
+            } else {
+                break;
+            }
+            start_piece(host, piece, now);
+        }
+
+        if (split && handed_out_again.empty() && next_slice == plan.slices) {
+            while (split_late_piece(hosts, options, done, now)) splits++;
+        }
+
+        /**
+         *  On to the next piece to finish, deadline or checkpoint.
+         */
+        double next = (floor(now / options.checkpoint_interval) + 1) * options.checkpoint_interval;
+        for (unsigned int i = 0; i < hosts.size(); i++) {
+            const sim_host &host = hosts[i];
+            if (!host.busy) continue;
+            if (finish_time(host) < next) next = finish_time(host);
+            if (!host.handed_out_again && host.start + options.deadline < next) next = host.start + options.deadline;
+        }
+        if (next > horizon) return HUGE_VAL;
+        now = (next > now) ? next : now;
+    }
+    return now;
+}
+
+static void print_usage() {
+    fprintf(stderr, "USAGE:\n");
+    fprintf(stderr, "\t./simulate_stragglers [--hosts <h>] [--slices <s>] [--slice_seconds <s>] [--checkpoint_interval <s>] [--deadline <s>]\n");
+    fprintf(stderr, "\t                      [--spread <x>] [--slow_fraction <f>] [--slow_factor <x>] [--quit_fraction <f>] [--runs <r>] [--seed <n>]\n\n");
+    fprintf(stderr, "\t--hosts               :   how many hosts (default 100).\n");
+    fprintf(stderr, "\t--slices              :   how many slices (default 2000).\n");
+    fprintf(stderr, "\t--slice_seconds       :   seconds a slice takes on a typical host (default 3600).\n");
+    fprintf(stderr, "\t--checkpoint_interval :   seconds between checkpoints (default 300).\n");
+    fprintf(stderr, "\t--deadline            :   seconds before a slice is handed out again (default 4 slices).\n");
+    fprintf(stderr, "\t--spread              :   sigma of the lognormal spread of host speeds (default 0.3).\n");
+    fprintf(stderr, "\t--slow_fraction       :   fraction of the hosts which are slower again (default 0.05).\n");
+    fprintf(stderr, "\t--slow_factor         :   how much slower they are (default 10).\n");
+    fprintf(stderr, "\t--quit_fraction       :   fraction of the hosts which stop for good part way (default 0.01).\n");
+    fprintf(stderr, "\t--runs                :   how many runs, each with its own hosts (default 10).\n");
+    fprintf(stderr, "\t--seed                :   the seed of the first run (default 1).\n");
+}
+
+int main(int argc, char** argv) {
+    sim_options options;
+    options.hosts = 100;
+    options.slices = 2000;
+    options.slice_seconds = 3600;
+    options.checkpoint_interval = 300;
+    options.deadline = 0;
+    options.spread = 0.3;
+    options.slow_fraction = 0.05;
+    options.slow_factor = 10;
+    options.quit_fraction = 0.01;
+    unsigned int runs = 10;
+    unsigned long long seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            print_usage();
+            exit(0);
+        }
+
+        if (strcmp(argv[i], "--hosts") == 0)                        options.hosts = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--slices") == 0)                  options.slices = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--slice_seconds") == 0)           options.slice_seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--checkpoint_interval") == 0)     options.checkpoint_interval = atof(argv[++i]);
+        else if (strcmp(argv[i], "--deadline") == 0)                options.deadline = atof(argv[++i]);
+        else if (strcmp(argv[i], "--spread") == 0)                  options.spread = atof(argv[++i]);
+        else if (strcmp(argv[i], "--slow_fraction") == 0)           options.slow_fraction = atof(argv[++i]);
+        else if (strcmp(argv[i], "--slow_factor") == 0)             options.slow_factor = atof(argv[++i]);
+        else if (strcmp(argv[i], "--quit_fraction") == 0)           options.quit_fraction = atof(argv[++i]);
+        else if (strcmp(argv[i], "--runs") == 0)                    runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0)                    seed = strtoull(argv[++i], NULL, 10);
+        else {
+            print_usage();
+            exit(0);
+        }
+    }
+    if (options.deadline <= 0) options.deadline = 4 * options.slice_seconds;
+
+    if (options.hosts == 0 || options.slices == 0 || options.slice_seconds <= 0 || options.checkpoint_interval <= 0 || options.slow_factor < 1 || runs == 0) {
+        fprintf(stderr, "ERROR: the hosts, slices, seconds and runs must be more than 0, and the slow factor at least 1.\n");
+        exit(0);
+    }
+
+    /**
+     *  Hosts quit some time in the first half of a run, and a run which hasn't finished by 100 times its ideal
+     *  time is given up on.
+     */
+    double ideal_guess = (options.slices * options.slice_seconds) / options.hosts;
+    double horizon = 100 * (ideal_guess + options.deadline);
+
+    printf("seed\tideal_seconds\tleft_seconds\tsplit_seconds\tsplits\tgain\n");
+    double total_gain = 0;
+    for (unsigned int run = 0; run < runs; run++) {
+        sim_seed = (seed + run) * 0x9E3779B97F4A7C15ULL + 1;
+
+        vector<sim_host> hosts;
+        make_hosts(options, ideal_guess / 2, hosts);
+
+        double rates = 0;
+        for (unsigned int i = 0; i < hosts.size(); i++) {
+            if (hosts[i].quit_time == HUGE_VAL) rates += hosts[i].rate;
+        }
+        double ideal = (options.slices * options.slice_seconds * TYPICAL_RATE) / rates;
+
+        unsigned int no_splits, splits;
+        double left = simulate(hosts, options, false, horizon, no_splits);
+        double split = simulate(hosts, options, true, horizon, splits);
+        double gain = 1 - (split / left);
+        total_gain += gain;
+
+        printf("%llu\t%.0lf\t%.0lf\t%.0lf\t%u\t%.3lf\n", seed + run, ideal, left, split, splits, gain);
+    }
+    printf("mean gain: %.3lf\n", total_gain / runs);
+    return 0;
+}
@@ -0,0 +1,740 @@
+/**
+ *  So the merged output (and its length in the journal) can grow past 2GB on 32 bit builds.
+ */
+#define _FILE_OFFSET_BITS 64
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "sss_slices.hpp"
+#include "sss_stragglers.hpp"
+
+using namespace std;
+
+/**
+ *  Runs a whole (M, N) problem on one machine, standing in for the BOINC server: the subsets are split into slices the
+ *  same way as sss_work_generator (see sss_slices.hpp), and handed out to client workers (each running
+ *  subset_sum --daemon, reading a slice on its stdin and answering with a result line on its stdout), eg:
+ *
+ *      g++ -Wall -O2 sss_coordinator.cpp -o sss_coordinator
+ *      ./sss_coordinator --client ../bin/subset_sum --workers 16 --target_seconds 60 100 8
+ *
+ *  Each worker gets one slice at a time, and another when it answers.  If a worker dies (or its pipe breaks), its
+ *  slice (after its last checkpoint) is handed out again (first, before any new slices), and a new worker is started
+ *  in its place.  A slice which
+ *  has killed MAX_SLICE_ATTEMPTS workers stops the run, as it would kill every worker.  --kill_interval kills a random
+ *  busy worker every so many seconds, to test this.
+ *
+ *  With --checkpoint_interval (for clients compiled with -DENABLE_CHECKPOINTING), the workers report how far they
+ *  have got with their slice every so many seconds.  Once every slice has been handed out, a late slice (see
+ *  sss_stragglers.hpp) has what it tested up to its last checkpoint kept, and the rest split into sub-slices for the
+ *  idle workers, sized by how fast each has been, and its worker is restarted.  --no_split turns this off.
+ *
+ *  Finished slices are merged in order: with --output, the failed sets a worker printed for a slice (if the client was
+ *  compiled with -DVERBOSE) are written there in rank order, so it holds the same failed sets as one run of the whole
+ *  problem.  With --journal, after each slice is merged the output is synced and a line with the next slice to merge,
+ *  the pass and fail counts so far and the length of the output is appended (and synced) to the journal, so a
+ *  coordinator which is restarted carries on from the last merged slice (cutting off anything written to the output
+ *  after it).  Slices finished out of order but not merged yet are tested again after a restart.
+ *
+ *  At the end the totals are printed (in the same form as the client), which must add up to every subset, with the
+ *  aggregate subsets per second and what each worker did.
+ */
+const unsigned int MAX_SLICE_ATTEMPTS = 3;
+const double PROGRESS_INTERVAL = 10;
+const unsigned int MAX_LINE_LENGTH = 4096;
+
+/**
+ *  A slice, or part of one (after a worker died part way through it, or it was split).
+ */
+struct slice_piece {
+    subset_rank_t first_rank;
+    subset_rank_t count;
+    unsigned int splits;            // how many times the slice it is part of has been split
+};
+
+struct worker {
+    pid_t pid;
+    int input;                      // the worker's stdin
+    int output;                     // the worker's stdout
+    string received;                // output not yet split into lines
+    string failed_sets;             // lines printed for the piece being tested, since its last checkpoint
+
+    bool busy;
+    slice_piece piece;
+    double piece_start;
+
+    subset_rank_t done;             // as of the last checkpoint of the piece
+    unsigned long long done_pass;
+    unsigned long long done_fail;
+    string done_failed_sets;
+
+    unsigned long long pieces;
+    subset_rank_t subsets;
+    double busy_seconds;
+};
+
+struct piece_result {
+    subset_rank_t count;
+    unsigned long long pass;
+    unsigned long long fail;
+    string failed_sets;
+};
+
+struct coordinator {
+    slice_plan plan;
+    const char *client;
+    const char *order;
+
+    vector<worker> workers;
+    double checkpoint_interval;
+    bool split;
+
+    deque<slice_piece> reassigned;                  // pieces of dead workers, handed out before new slices
+    map<subset_rank_t, unsigned int> attempts;      // of pieces (by first rank) which have killed a worker
+    subset_rank_t next_slice;                       // the first slice not handed out yet
+
+    map<subset_rank_t, piece_result> finished;      // finished pieces (by first rank) waiting for the ones before them
+    subset_rank_t next_to_merge;                    // the rank of the first subset not merged yet
+    subset_rank_t pass;
+    subset_rank_t fail;
+    subset_rank_t merged_subsets;                   // merged in this run (not before a restart)
+
+    FILE *output;
+    long long output_length;
+    FILE *journal;
+
+    unsigned int crashes;
+    unsigned int splits;
+};
+
+static double wall_time() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + (now.tv_usec / 1e6);
+}
+
+static void sync_file(FILE *file) {
+    fflush(file);
+    fsync(fileno(file));
+}
+
+/**
+ *  Starts a client worker in workers[index].
+ */
+static void start_worker(coordinator &run, const unsigned int index) {
+    int to_worker[2], from_worker[2];
+    if (pipe(to_worker) != 0 || pipe(from_worker) != 0) {
+        fprintf(stderr, "ERROR: could not make the pipes for a worker.\n");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "ERROR: could not start a worker.\n");
+        exit(1);
+    }
+
+    if (pid == 0) {
+        dup2(to_worker[0], 0);
+        dup2(from_worker[1], 1);
+        close(to_worker[0]);
+        close(to_worker[1]);
+        close(from_worker[0]);
+        close(from_worker[1]);
+
+        if (run.checkpoint_interval > 0) {
+            char interval[64];
+            sprintf(interval, "%lf", run.checkpoint_interval);
+            execl(run.client, run.client, "--order", run.order, "--progress-interval", interval, "--checkpoint-interval", interval, "--daemon", (char*)NULL);
+        } else {
+            execl(run.client, run.client, "--order", run.order, "--daemon", (char*)NULL);
+        }
+        fprintf(stderr, "ERROR: could not run the client '%s'.\n", run.client);
+        _exit(1);
+    }
+
+    close(to_worker[0]);
+    close(from_worker[1]);
+    fcntl(to_worker[1], F_SETFD, FD_CLOEXEC);
+    fcntl(from_worker[0], F_SETFD, FD_CLOEXEC);
+
+    worker &w = run.workers[index];
+    w.pid = pid;
+    w.input = to_worker[1];
+    w.output = from_worker[0];
+    w.received.clear();
+    w.failed_sets.clear();
+    w.busy = false;
+}
+
+static void stop_worker(worker &w) {
+    close(w.input);
+    close(w.output);
+    waitpid(w.pid, NULL, 0);
+}
+
+/**
+ *  Sends the worker a piece to test.
+ */
+static void assign_piece(worker &w, const slice_piece &piece, const slice_plan &plan) {
+    char job[MAX_LINE_LENGTH];
+    slice_arguments(plan, piece.first_rank, piece.count, job);
+    strcat(job, "\n");
+
+    w.busy = true;
+    w.piece = piece;
+    w.piece_start = wall_time();
+    w.failed_sets.clear();
+    w.done = 0;
+    w.done_pass = 0;
+    w.done_fail = 0;
+    w.done_failed_sets.clear();
+
+    /**
+     *  A worker which has died can't be written to, which is picked up (as a closed pipe) by the main loop.
+     */
+    if (write(w.input, job, strlen(job)) != (ssize_t)strlen(job)) {
+        close(w.input);
+        w.input = -1;
+    }
+}
+
+/**
+ *  Hands the worker the next piece (a dead worker's piece first, then the next slice).  Returns false if there are
+ *  none left.
+ */
+static bool assign_next_piece(coordinator &run, worker &w) {
+    slice_piece piece;
+    if (!run.reassigned.empty()) {
+        piece = run.reassigned.front();
+        run.reassigned.pop_front();
+    } else if (run.next_slice < run.plan.slices) {
+        piece.first_rank = run.next_slice * run.plan.slice_size;
+        piece.count = slice_count(run.plan, piece.first_rank);
+        piece.splits = 0;
+        run.next_slice++;
+    } else {
+        return false;
+    }
+
+    assign_piece(w, piece, run.plan);
+    return true;
+}
+
+/**
+ *  Writes the finished pieces which are next in order to the output, and records them in the journal.
+ */
+static void merge_pieces(coordinator &run) {
+    map<subset_rank_t, piece_result>::iterator next;
+
+    while ((next = run.finished.find(run.next_to_merge)) != run.finished.end()) {
+        piece_result &result = next->second;
+
+        if (run.output != NULL && !result.failed_sets.empty()) {
+            fwrite(result.failed_sets.data(), 1, result.failed_sets.size(), run.output);
+            run.output_length += result.failed_sets.size();
+        }
+
+        run.pass += result.pass;
+        run.fail += result.fail;
+        run.merged_subsets += result.count;
+        run.next_to_merge += result.count;
+        run.finished.erase(next);
+
+        if (run.journal != NULL) {
+            char next_string[RANK_STRING_LENGTH], pass_string[RANK_STRING_LENGTH], fail_string[RANK_STRING_LENGTH];
+            if (run.output != NULL) sync_file(run.output);
+            fprintf(run.journal, "%s %s %s %lld\n", rank_to_string(run.next_to_merge, next_string), rank_to_string(run.pass, pass_string), rank_to_string(run.fail, fail_string), run.output_length);
+            sync_file(run.journal);
+        }
+    }
+}
+
+/**
+ *  Keeps what a worker tested of its piece up to its last checkpoint (as a finished piece), leaving the rest of the
+ *  piece in w.piece.
+ */
+static void keep_checkpointed(coordinator &run, worker &w) {
+    if (w.done == 0) return;
+
+    piece_result result;
+    result.count = w.done;
+    result.pass = w.done_pass;
+    result.fail = w.done_fail;
+    result.failed_sets.swap(w.done_failed_sets);
+    run.finished[w.piece.first_rank] = result;
+
+    w.piece.first_rank += w.done;
+    w.piece.count -= w.done;
+    w.subsets += w.done;
+    w.done = 0;
+    merge_pieces(run);
+}
+
+/**
+ *  A worker died (or stopped answering properly): what it hadn't checkpointed of its piece is handed out again, and
+ *  another worker is started.
+ */
+static void worker_died(coordinator &run, const unsigned int index) {
+    worker &w = run.workers[index];
+    char slice_string[RANK_STRING_LENGTH] = "";
+
+    if (w.input >= 0) close(w.input);
+    close(w.output);
+
+    int status = 0;
+    waitpid(w.pid, &status, 0);
+    run.crashes++;
+
+    keep_checkpointed(run, w);
+    if (w.busy && w.piece.count == 0) w.busy = false;
+
+    if (w.busy) {
+        rank_to_string(w.piece.first_rank, slice_string);
+        if (++run.attempts[w.piece.first_rank] >= MAX_SLICE_ATTEMPTS) {
+            fprintf(stderr, "ERROR: the slice from subset %s has killed %u workers, stopping.\n", slice_string, MAX_SLICE_ATTEMPTS);
+            exit(1);
+        }
+        run.reassigned.push_front(w.piece);
+    }
+
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "worker %u (pid %d) was killed by signal %d%s%s.\n", index, (int)w.pid, WTERMSIG(status), w.busy ? ", handing out the slice from subset " : "", w.busy ? slice_string : "");
+    } else {
+        fprintf(stderr, "worker %u (pid %d) stopped%s%s.\n", index, (int)w.pid, w.busy ? ", handing out the slice from subset " : "", w.busy ? slice_string : "");
+    }
+
+    start_worker(run, index);
+}
+
+/**
+ *  Handles a line from a worker: a failed set (kept with its piece), a checkpoint, or the result of its piece.
+ */
+static void worker_line(coordinator &run, const unsigned int index, const string &line) {
+    worker &w = run.workers[index];
+
+    if (line.compare(0, 11, "checkpoint ") == 0) {
+        char done_string[RANK_STRING_LENGTH];
+        unsigned long long pass, fail;
+        subset_rank_t done;
+
+        if (!w.busy || sscanf(line.c_str(), "checkpoint %40s %llu %llu", done_string, &pass, &fail) != 3
+            || !parse_rank(done_string, done) || done > w.piece.count || pass + fail != done
+        ) {
+            fprintf(stderr, "ERROR: worker %u answered '%s', which is not a checkpoint of its slice.\n", index, line.c_str());
+            exit(1);
+        }
+
+        w.done = done;
+        w.done_pass = pass;
+        w.done_fail = fail;
+        w.done_failed_sets += w.failed_sets;
+        w.failed_sets.clear();
+        return;
+    }
+
+    if (line.compare(0, 7, "result ") != 0) {
+        if (line.compare(0, 6, "error ") == 0) {
+            fprintf(stderr, "ERROR: worker %u could not run its slice: %s\n", index, line.c_str() + 6);
+            exit(1);
+        }
+        w.failed_sets += line;
+        w.failed_sets += "\n";
+        return;
+    }
+
+    unsigned int M, N;
+    char first_string[RANK_STRING_LENGTH], count_string[RANK_STRING_LENGTH];
+    subset_rank_t first_rank, count;
+    piece_result result;
+    double seconds;
+
+    if (!w.busy
+        || sscanf(line.c_str(), "result %u %u %40s %40s %llu %llu %lf", &M, &N, first_string, count_string, &result.pass, &result.fail, &seconds) != 7
+        || !parse_rank(first_string, first_rank) || !parse_rank(count_string, count)
+        || M != run.plan.max_set_value || N != run.plan.subset_size || first_rank != w.piece.first_rank
+        || count != w.piece.count || result.pass + result.fail != count
+    ) {
+        fprintf(stderr, "ERROR: worker %u answered '%s', which is not the result of its slice.\n", index, line.c_str());
+        exit(1);
+    }
+
+    result.count = count;
+    result.failed_sets = w.done_failed_sets + w.failed_sets;
+    run.finished[first_rank] = result;
+
+    w.busy = false;
+    w.pieces++;
+    w.subsets += count;
+    w.busy_seconds += wall_time() - w.piece_start;
+
+    merge_pieces(run);
+}
+
+/**
+ *  The subsets per second a worker has tested so far, or typical_rate if it hasn't finished anything yet.
+ */
+static double worker_rate(const worker &w, const double typical_rate) {
+    if (w.subsets == 0 || w.busy_seconds <= 0) return typical_rate;
+    return (double)w.subsets / w.busy_seconds;
+}
+
+/**
+ *  Once every slice has been handed out, splits the first late piece between the idle workers (see
+ *  sss_stragglers.hpp), keeping what it tested up to its last checkpoint and restarting its worker.
+ */
+static void split_late_piece(coordinator &run) {
+    if (!run.reassigned.empty() || run.next_slice < run.plan.slices) return;
+
+    /**
+     *  A typical worker is one with the average speed of those which have finished something (until one has, the
+     *  plan's subsets per second is only a guess, so nothing is split).
+     */
+    double rates = 0;
+    unsigned int measured = 0;
+    vector<unsigned int> helpers;
+    for (unsigned int i = 0; i < run.workers.size(); i++) {
+        if (!run.workers[i].busy) helpers.push_back(i);
+        if (run.workers[i].subsets > 0) {
+            rates += worker_rate(run.workers[i], 0);
+            measured++;
+        }
+    }
+    if (helpers.empty() || measured == 0) return;
+    double typical_rate = rates / measured;
+
+    vector<double> helper_rates;
+    for (unsigned int i = 0; i < helpers.size(); i++) helper_rates.push_back(worker_rate(run.workers[helpers[i]], typical_rate));
+
+    double now = wall_time();
+    for (unsigned int i = 0; i < run.workers.size(); i++) {
+        worker &w = run.workers[i];
+        if (!w.busy || w.piece.splits >= MAX_SPLITS) continue;
+
+        double elapsed = now - w.piece_start;
+        if (!slice_is_late(w.piece.count, w.done, elapsed, typical_rate)) continue;
+
+        vector<subset_rank_t> counts;
+        if (!plan_split(w.piece.count - w.done, slice_rate(w.done, elapsed), typical_rate, helper_rates, counts)) continue;
+
+        char first_string[RANK_STRING_LENGTH], done_string[RANK_STRING_LENGTH];
+        fprintf(stderr, "worker %u is late with the slice from subset %s (%s tested), splitting the rest between %u workers.\n",
+            i, rank_to_string(w.piece.first_rank, first_string), rank_to_string(w.done, done_string), (unsigned int)counts.size());
+
+        keep_checkpointed(run, w);
+
+        slice_piece piece;
+        piece.first_rank = w.piece.first_rank;
+        piece.splits = w.piece.splits + 1;
+        for (unsigned int j = 0; j < counts.size(); j++) {
+            piece.count = counts[j];
+            assign_piece(run.workers[helpers[j]], piece, run.plan);
+            piece.first_rank += counts[j];
+        }
+
+        w.busy = false;
+        w.busy_seconds += elapsed;
+        kill(w.pid, SIGKILL);
+        stop_worker(w);
+        start_worker(run, i);
+
+        run.splits++;
+        return;
+    }
+}
+
+/**
+ *  Reads what a worker has written, handling each whole line.  Returns false if the worker has closed its stdout
+ *  (it has died).
+ */
+static bool read_worker(coordinator &run, const unsigned int index) {
+    char buffer[MAX_LINE_LENGTH];
+    ssize_t bytes = read(run.workers[index].output, buffer, sizeof(buffer));
+    if (bytes < 0 && errno == EINTR) return true;
+    if (bytes <= 0) return false;
+
+    worker &w = run.workers[index];
+    w.received.append(buffer, bytes);
+
+    size_t start = 0, end;
+    while ((end = w.received.find('\n', start)) != string::npos) {
+        worker_line(run, index, w.received.substr(start, end - start));
+        start = end + 1;
+    }
+    w.received.erase(0, start);
+    return true;
+}
+
+/**
+ *  Carries on from the last line of the journal (if it is for the same slices), or starts it.
+ */
+static void open_journal(coordinator &run, const char *journal_file, const char *output_file) {
+    char header[MAX_LINE_LENGTH], expected[MAX_LINE_LENGTH], line[MAX_LINE_LENGTH], size_string[RANK_STRING_LENGTH];
+    sprintf(expected, "%u %u %s\n", run.plan.max_set_value, run.plan.subset_size, rank_to_string(run.plan.slice_size, size_string));
+
+    FILE *journal = fopen(journal_file, "r");
+    bool resumed = (journal != NULL);
+    if (resumed) {
+        if (fgets(header, MAX_LINE_LENGTH, journal) == NULL || strcmp(header, expected) != 0) {
+            header[strcspn(header, "\n")] = '\0';
+            expected[strcspn(expected, "\n")] = '\0';
+            fprintf(stderr, "ERROR: the journal '%s' is for other slices (it starts with '%.40s', not '%.40s').\n", journal_file, header, expected);
+            exit(0);
+        }
+
+        /**
+         *  Only whole lines count, as the last one may have been cut off.
+         */
+        char next_string[RANK_STRING_LENGTH] = "0", pass_string[RANK_STRING_LENGTH], fail_string[RANK_STRING_LENGTH];
+        long long output_length;
+        while (fgets(line, MAX_LINE_LENGTH, journal) != NULL) {
+            if (strchr(line, '\n') == NULL) break;
+            if (sscanf(line, "%40s %40s %40s %lld", next_string, pass_string, fail_string, &output_length) != 4
+                || !parse_rank(next_string, run.next_to_merge) || !parse_rank(pass_string, run.pass) || !parse_rank(fail_string, run.fail)
+            ) {
+                fprintf(stderr, "ERROR: the journal '%s' has a line which can't be read: '%s'.\n", journal_file, line);
+                exit(0);
+            }
+            run.output_length = output_length;
+        }
+        fclose(journal);
+
+        /**
+         *  After a split, the journal can stop part way through a slice, whose rest is handed out first.
+         */
+        run.next_slice = run.next_to_merge / run.plan.slice_size;
+        if (run.next_to_merge % run.plan.slice_size != 0) {
+            slice_piece rest;
+            rest.first_rank = run.next_to_merge;
+            rest.count = slice_count(run.plan, run.next_slice * run.plan.slice_size) - (run.next_to_merge % run.plan.slice_size);
+            rest.splits = 0;
+            run.reassigned.push_back(rest);
+            run.next_slice++;
+        }
+        fprintf(stderr, "carrying on from subset %s of %s (from the journal).\n", next_string, rank_to_string(run.plan.total, size_string));
+    }
+
+    if (output_file != NULL) {
+        int fd = open(output_file, O_RDWR | O_CREAT, 0644);
+        if (fd < 0 || ftruncate(fd, (off_t)run.output_length) != 0 || (long long)lseek(fd, 0, SEEK_END) != run.output_length) {
+            fprintf(stderr, "ERROR: could not open the output '%s' (or cut it to the journal's length).\n", output_file);
+            exit(0);
+        }
+        run.output = fdopen(fd, "w");
+    }
+
+    run.journal = fopen(journal_file, resumed ? "a" : "w");
+    if (run.journal == NULL) {
+        fprintf(stderr, "ERROR: could not write the journal '%s'.\n", journal_file);
+        exit(0);
+    }
+    if (!resumed) {
+        fputs(expected, run.journal);
+        sync_file(run.journal);
+    }
+}
+
+static void print_usage() {
+    fprintf(stderr, "USAGE:\n");
+    fprintf(stderr, "\t./sss_coordinator [--client <path>] [--workers <w>] [--target_seconds <s>] [--throughput_file <file>] [--order <o>]\n");
+    fprintf(stderr, "\t                  [--output <file>] [--journal <file>] [--checkpoint_interval <s>] [--no_split] [--kill_interval <s>] <M> <N>\n\n");
+    fprintf(stderr, "\t<M>                :   The maximum value allowed in the sets.\n");
+    fprintf(stderr, "\t<N>                :   The number of elements allowed in a set.\n");
+    fprintf(stderr, "\t--client           :   the client to run as workers (default ./subset_sum).\n");
+    fprintf(stderr, "\t--workers          :   how many workers to run (default the number of CPUs).\n");
+    fprintf(stderr, "\t--target_seconds   :   seconds each slice should take (default 60).\n");
+    fprintf(stderr, "\t--throughput_file  :   kernel benchmark with the measured throughput (default kernel_benchmark.tsv).\n");
+    fprintf(stderr, "\t--order            :   the order the workers test the subsets in (default lexicographic).\n");
+    fprintf(stderr, "\t--output           :   where to write the failed sets printed by the workers, in order.\n");
+    fprintf(stderr, "\t--journal          :   where to record the merged slices, to carry on from after a restart.\n");
+    fprintf(stderr, "\t--checkpoint_interval :   seconds between the workers' checkpoints (needs a client compiled with -DENABLE_CHECKPOINTING).\n");
+    fprintf(stderr, "\t--no_split         :   don't split late slices between idle workers.\n");
+    fprintf(stderr, "\t--kill_interval    :   kill a random busy worker every <s> seconds (to test handing slices out again).\n");
+}
+
+int main(int argc, char** argv) {
+    coordinator run;
+    run.client = "./subset_sum";
+    run.order = "lexicographic";
+    run.next_slice = 0;
+    run.next_to_merge = 0;
+    run.pass = 0;
+    run.fail = 0;
+    run.merged_subsets = 0;
+    run.output = NULL;
+    run.output_length = 0;
+    run.journal = NULL;
+    run.crashes = 0;
+    run.splits = 0;
+    run.checkpoint_interval = 0;
+    run.split = true;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int number_workers = (cpus > 0) ? cpus : 1;
+    double target_seconds = 60;
+    double kill_interval = 0;
+    const char *throughput_file = "kernel_benchmark.tsv";
+    const char *output_file = NULL;
+    const char *journal_file = NULL;
+
+    int positional_arguments = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--client") == 0 && i + 1 < argc) {
+            run.client = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            number_workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--target_seconds") == 0 && i + 1 < argc) {
+            target_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--throughput_file") == 0 && i + 1 < argc) {
+            throughput_file = argv[++i];
+        } else if (strcmp(argv[i], "--order") == 0 && i + 1 < argc) {
+            run.order = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_file = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint_interval") == 0 && i + 1 < argc) {
+            run.checkpoint_interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--no_split") == 0) {
+            run.split = false;
+        } else if (strcmp(argv[i], "--kill_interval") == 0 && i + 1 < argc) {
+            kill_interval = atof(argv[++i]);
+        } else {
+            argv[positional_arguments++] = argv[i];
+        }
+    }
+    argc = positional_arguments;
+
+    if (argc != 3 || number_workers == 0 || target_seconds <= 0 || kill_interval < 0 || run.checkpoint_interval < 0) {
+        fprintf(stderr, "ERROR, wrong command line arguments.\n");
+        print_usage();
+        exit(0);
+    }
+
+    unsigned int max_set_value = atoi(argv[1]);
+    unsigned int subset_size = atoi(argv[2]);
+
+    throughput_model model;
+    if (!read_throughput_file(throughput_file, model)) {
+        fprintf(stderr, "could not read the throughput from '%s', using a rough guess.\n", throughput_file);
+    }
+
+    /**
+     *  The binomials go up to M - 1 choose N - 1, so an M or N of 0 is caught first.
+     */
+    const char *error = "N must be from 1 to M";
+    bool planned = (subset_size != 0 && subset_size <= max_set_value);
+    if (planned) {
+        init_binomials(max_set_value - 1, subset_size - 1);
+        planned = plan_slices(model, max_set_value, subset_size, target_seconds, run.plan, error);
+    }
+    if (!planned) {
+        fprintf(stderr, "ERROR: can't slice the sets of %u from 1..%u containing %u: %s.\n", subset_size, max_set_value, max_set_value, error);
+        exit(0);
+    }
+
+    if (journal_file != NULL) {
+        open_journal(run, journal_file, output_file);
+    } else if (output_file != NULL) {
+        run.output = fopen(output_file, "w");
+        if (run.output == NULL) {
+            fprintf(stderr, "ERROR: could not write the output '%s'.\n", output_file);
+            exit(0);
+        }
+    }
+
+    char total_string[RANK_STRING_LENGTH], size_string[RANK_STRING_LENGTH], slices_string[RANK_STRING_LENGTH];
+    fprintf(stderr, "%s subsets (sets of %u from 1..%u containing %u) in %s slices of %s, on %u workers.\n",
+        rank_to_string(run.plan.total, total_string), subset_size, max_set_value, max_set_value, rank_to_string(run.plan.slices, slices_string), rank_to_string(run.plan.slice_size, size_string), number_workers);
+
+    /**
+     *  Writing to a worker which has died shouldn't stop the coordinator.
+     */
+    signal(SIGPIPE, SIG_IGN);
+
+    run.workers.resize(number_workers);
+    for (unsigned int i = 0; i < number_workers; i++) {
+        run.workers[i].pieces = 0;
+        run.workers[i].subsets = 0;
+        run.workers[i].busy_seconds = 0;
+        start_worker(run, i);
+    }
+
+    double start = wall_time();
+    double last_progress = start;
+    double last_kill = start;
+    vector<struct pollfd> polls(number_workers);
+
+    while (run.next_to_merge < run.plan.total) {
+        for (unsigned int i = 0; i < number_workers; i++) {
+            if (!run.workers[i].busy) assign_next_piece(run, run.workers[i]);
+        }
+
+        for (unsigned int i = 0; i < number_workers; i++) {
+            polls[i].fd = run.workers[i].output;
+            polls[i].events = POLLIN;
+            polls[i].revents = 0;
+        }
+        if (poll(&polls[0], number_workers, 1000) < 0 && errno != EINTR) {
+            fprintf(stderr, "ERROR: could not wait for the workers.\n");
+            exit(1);
+        }
+
+        for (unsigned int i = 0; i < number_workers; i++) {
+            if (polls[i].revents == 0) continue;
+            if (run.workers[i].input < 0 || !read_worker(run, i)) worker_died(run, i);
+        }
+        if (run.split) split_late_piece(run);
+
+        double now = wall_time();
+        if (kill_interval > 0 && now - last_kill >= kill_interval) {
+            unsigned int index = rand() % number_workers;
+            if (run.workers[index].busy) kill(run.workers[index].pid, SIGKILL);
+            last_kill = now;
+        }
+
+        if (now - last_progress >= PROGRESS_INTERVAL) {
+            char merged_string[RANK_STRING_LENGTH];
+            fprintf(stderr, "%s of %s subsets merged, %.0lf subsets per second.\n", rank_to_string(run.next_to_merge, merged_string), total_string, (double)run.merged_subsets / (now - start));
+            last_progress = now;
+        }
+    }
+
+    double seconds = wall_time() - start;
+    for (unsigned int i = 0; i < number_workers; i++) stop_worker(run.workers[i]);
+    if (run.output != NULL) fclose(run.output);
+    if (run.journal != NULL) fclose(run.journal);
+
+    char pass_string[RANK_STRING_LENGTH], fail_string[RANK_STRING_LENGTH], subsets_string[RANK_STRING_LENGTH];
+    subset_rank_t tested = run.pass + run.fail;
+    printf("%s total sets, %s sets passed, %s sets failed, %lf success rate.\n", rank_to_string(tested, subsets_string),
+        rank_to_string(run.pass, pass_string), rank_to_string(run.fail, fail_string), (double)run.pass / (double)tested);
+    printf("%u workers tested %s subsets in %.3lf seconds, %.0lf subsets per second (%u workers died, %u late slices split).\n", number_workers,
+        rank_to_string(run.merged_subsets, subsets_string), seconds, (double)run.merged_subsets / seconds, run.crashes, run.splits);
+    for (unsigned int i = 0; i < number_workers; i++) {
+        worker &w = run.workers[i];
+        printf("    worker %u: %llu slices, %s subsets, busy %.1lf%% of the time.\n", i, w.pieces, rank_to_string(w.subsets, subsets_string), 100 * w.busy_seconds / seconds);
+    }
+
+    if (tested != run.plan.total) {
+        fprintf(stderr, "ERROR: the slices add up to %s subsets, not %s.\n", rank_to_string(tested, subsets_string), total_string);
+        exit(1);
+    }
+    return 0;
+}
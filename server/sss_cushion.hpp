@@ -0,0 +1,93 @@
+#ifndef SSS_CUSHION_HPP
+#define SSS_CUSHION_HPP
+
+/**
+ *  How many unsent jobs the work generator keeps, and how long it waits before looking again, from the rate the
+ *  scheduler is handing them out.  A fixed cushion (and sleep) is either too small for a big campaign, where hosts
+ *  run out of work between passes, or makes far more jobs than are needed for a small one.
+ *
+ *  After each pass, the jobs dispatched since the last one are the unsent jobs left then (including the ones just
+ *  made) less the unsent jobs now, which gives the dispatch rate.  The rate is smoothed (so one busy or quiet pass
+ *  doesn't swing the cushion), but if every job was handed out the rate was held back by the cushion, so it is at
+ *  least doubled instead.  The cushion is lead_seconds worth of jobs at that rate, between min_jobs and
+ *  max_jobs.  The next pass is when about half the cushion should have been handed out, but at least
+ *  MIN_POLL_SECONDS and at most MAX_POLL_SECONDS later (and FIRST_POLL_SECONDS later until there is a rate).
+ */
+const double RATE_SMOOTHING = 0.3;
+const double FIRST_POLL_SECONDS = 5;
+const double MIN_POLL_SECONDS = 1;
+const double MAX_POLL_SECONDS = 60;
+
+struct dispatch_cushion {
+    double lead_seconds;
+    int min_jobs;
+    int max_jobs;
+
+    double jobs_per_second;
+    bool measured;
+    double last_time;
+    int last_unsent;
+};
+
+inline void init_dispatch_cushion(dispatch_cushion &cushion, const double lead_seconds, const int min_jobs, const int max_jobs) {
+    cushion.lead_seconds = lead_seconds;
+    cushion.min_jobs = min_jobs;
+    cushion.max_jobs = (max_jobs < min_jobs) ? min_jobs : max_jobs;
+
+    cushion.jobs_per_second = 0;
+    cushion.measured = false;
+    cushion.last_time = -1;
+    cushion.last_unsent = 0;
+}
+
+/**
+ *  Updates the rate from the unsent jobs at time now (in seconds).  Does nothing on the first pass, or if no time has
+ *  passed.
+ */
+inline void update_dispatch_rate(dispatch_cushion &cushion, const double now, const int unsent) {
+    if (cushion.last_time < 0 || now <= cushion.last_time) return;
+
+    int dispatched = cushion.last_unsent - unsent;
+    if (dispatched < 0) dispatched = 0;
+
+    double rate = dispatched / (now - cushion.last_time);
+    if (!cushion.measured) {
+        cushion.jobs_per_second = rate;
+    } else if (unsent == 0 && dispatched > 0) {
+        cushion.jobs_per_second = (rate > 2 * cushion.jobs_per_second) ? rate : 2 * cushion.jobs_per_second;
+    } else {
+        cushion.jobs_per_second = (RATE_SMOOTHING * rate) + ((1 - RATE_SMOOTHING) * cushion.jobs_per_second);
+    }
+    cushion.measured = true;
+}
+
+/**
+ *  Records the unsent jobs at the end of a pass (after any jobs were made).
+ */
+inline void end_dispatch_pass(dispatch_cushion &cushion, const double now, const int unsent) {
+    cushion.last_time = now;
+    cushion.last_unsent = unsent;
+}
+
+inline int cushion_jobs(const dispatch_cushion &cushion) {
+    double jobs = cushion.jobs_per_second * cushion.lead_seconds;
+
+    if (jobs <= cushion.min_jobs) return cushion.min_jobs;
+    if (jobs >= cushion.max_jobs) return cushion.max_jobs;
+    return (int)jobs;
+}
+
+/**
+ *  Seconds until the next pass, with unsent jobs left at the end of this one.
+ */
+inline double poll_seconds(const dispatch_cushion &cushion, const int unsent) {
+    if (!cushion.measured) return FIRST_POLL_SECONDS;
+    if (cushion.jobs_per_second <= 0) return MAX_POLL_SECONDS;
+
+    double seconds = (unsent - (cushion_jobs(cushion) / 2.0)) / cushion.jobs_per_second;
+    if (seconds < MIN_POLL_SECONDS) return MIN_POLL_SECONDS;
+    if (seconds > MAX_POLL_SECONDS) return MAX_POLL_SECONDS;
+    return seconds;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SSS_JOBS_HPP
+#define SSS_JOBS_HPP
+
+#include <string>
+#include <vector>
+
+#include "sss_slices.hpp"
+
+/**
+ *  Making the jobs of a slice plan in batches, shared by sss_work_generator (against the BOINC database) and
+ *  benchmark_job_creation (against a SQLite stand-in for it), so the benchmark times the batching that is run on the
+ *  server.  The input files of a batch are all written first, then its workunits are inserted INSERT_ROWS at a time
+ *  (several rows per insert) in one transaction, which is committed once.
+ *
+ *  The jobs argument is the database the jobs are made in, which has:
+ *
+ *      int make_job(const subset_rank_t first_rank, std::string &values)
+ *          writes the input file of the slice starting at first_rank, and adds its workunit's row to values
+ *          (after a comma, if values isn't empty).
+ *      int start_transaction(), int insert_batch(std::string &values), int commit_transaction(),
+ *      int rollback_transaction()
+ *          as in the BOINC DB_CONN (and DB_WORKUNIT for insert_batch).
+ *
+ *  each returning 0 on success.
+ */
+const unsigned int INSERT_ROWS = 100;
+
+/**
+ *  Makes up to njobs jobs from first_rank (but none past the end of the plan) as one transaction, and moves first_rank
+ *  past them.  If it fails part way, the transaction is rolled back, so none of the batch is made and first_rank is
+ *  left where it was (the input files are written again by the next try).  Returns 0, or the error from jobs.
+ */
+template <typename jobs_t>
+int make_job_batch(jobs_t &jobs, const slice_plan &plan, subset_rank_t &first_rank, const unsigned int njobs) {
+    std::vector<std::string> inserts;
+    std::string values;
+    subset_rank_t rank = first_rank;
+    unsigned int rows = 0;
+    int retval;
+
+    for (unsigned int i = 0; i < njobs && rank < plan.total; i++) {
+        retval = jobs.make_job(rank, values);
+        if (retval) return retval;
+        rank += slice_count(plan, rank);
+
+        if (++rows == INSERT_ROWS) {
+            inserts.push_back(values);
+            values.clear();
+            rows = 0;
+        }
+    }
+    if (rows) inserts.push_back(values);
+
+    retval = jobs.start_transaction();
+    if (retval) return retval;
+    for (unsigned int i = 0; i < inserts.size(); i++) {
+        retval = jobs.insert_batch(inserts[i]);
+        if (retval) {
+            jobs.rollback_transaction();
+            return retval;
+        }
+    }
+    retval = jobs.commit_transaction();
+    if (retval) {
+        jobs.rollback_transaction();
+        return retval;
+    }
+
+    first_rank = rank;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef SSS_SLICES_HPP
+#define SSS_SLICES_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <cmath>
+
+#include <string>
+#include <vector>
+
+#include "../client/subset_ranks.hpp"
+
+/**
+ *  Splitting the (M - 1) choose (N - 1) subsets of an (M, N) problem into slices (the <i> <count> of the client), which
+ *  each take about target_seconds on the host the throughput was measured on.  The slices are all the same size (but
+ *  the last, which can be smaller), so none of them ends up as a straggler because it is bigger than the rest.
+ *
+ *  The throughput comes from the test_subsets rows of a kernel benchmark (kernel_benchmark.tsv written by the client
+ *  compiled with -DKERNEL_BENCHMARK, or the output of bin/benchmark_kernels.sh).  For an M and N which weren't measured,
+ *  the measurement with the nearest cost per subset (see subset_cost) is scaled by how much more or less each subset
+ *  costs, and with no measurements at all DEFAULT_WORD_SUBSETS_PER_SECOND is used (which is only a rough guess).
+ *
+ *  The fpops estimate of a slice is its predicted seconds times reference_fpops (the floating point benchmark of the
+ *  host the throughput was measured on, as BOINC divides the estimate by each host's benchmark), and the bound is
+ *  FPOPS_BOUND_FACTOR times that.
+ */
+const double DEFAULT_WORD_SUBSETS_PER_SECOND = 2e8;
+const double FPOPS_BOUND_FACTOR = 20.0;
+
+struct throughput_measurement {
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    double subsets_per_second;
+    unsigned int runs;
+};
+
+struct throughput_model {
+    std::vector<throughput_measurement> measurements;
+};
+
+/**
+ *  How much work testing a subset is: the sums of each of its N elements are calculated over a bitset with a 64 bit
+ *  word for every 64 sums up to half the largest subset sum (as in the client's select_sums_kernel).
+ */
+static inline double subset_cost(const unsigned int max_set_value, const unsigned int subset_size) {
+    unsigned long max_set_sum = 0;
+    for (unsigned int i = 0; i < subset_size && i < max_set_value; i++) max_set_sum += max_set_value - i;
+
+    unsigned long max_stored_sum = max_set_sum / 2;
+    if (max_stored_sum < max_set_value) max_stored_sum = max_set_value;
+
+    return (double)subset_size * ((max_stored_sum / 64) + 1);
+}
+
+/**
+ *  Splits line (without its newline) at its tabs.
+ */
+static inline void split_tabs(char *line, std::vector<std::string> &fields) {
+    fields.clear();
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char *start = line;
+    while (true) {
+        char *tab = strchr(start, '\t');
+        if (tab != NULL) *tab = '\0';
+        fields.push_back(start);
+        if (tab == NULL) break;
+        start = tab + 1;
+    }
+}
+
+static inline int find_column(const std::vector<std::string> &header, const char *name) {
+    for (unsigned int i = 0; i < header.size(); i++) {
+        if (header[i] == name) return i;
+    }
+    return -1;
+}
+
+/**
+ *  Adds the test_subsets rows of a kernel benchmark to model, where runs of the same M and N (eg with different
+ *  builds) are averaged.  Returns false if the file can't be read or doesn't have the kernel, M, N and
+ *  subsets_per_second columns.
+ */
+inline bool read_throughput_file(const char *filename, throughput_model &model) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) return false;
+
+    char line[4096];
+    std::vector<std::string> header, fields;
+    if (fgets(line, sizeof(line), file) == NULL) {
+        fclose(file);
+        return false;
+    }
+    split_tabs(line, header);
+
+    int kernel_column = find_column(header, "kernel");
+    int M_column = find_column(header, "M");
+    int N_column = find_column(header, "N");
+    int rate_column = find_column(header, "subsets_per_second");
+    if (kernel_column < 0 || M_column < 0 || N_column < 0 || rate_column < 0) {
+        fclose(file);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        split_tabs(line, fields);
+        if ((int)fields.size() != (int)header.size() || fields[kernel_column] != "test_subsets") continue;
+
+        unsigned int max_set_value = atoi(fields[M_column].c_str());
+        unsigned int subset_size = atoi(fields[N_column].c_str());
+        double subsets_per_second = atof(fields[rate_column].c_str());
+        if (max_set_value == 0 || subset_size == 0 || subsets_per_second <= 0) continue;
+
+        bool found = false;
+        for (unsigned int i = 0; i < model.measurements.size() && !found; i++) {
+            throughput_measurement &measurement = model.measurements[i];
+            if (measurement.max_set_value != max_set_value || measurement.subset_size != subset_size) continue;
+
+            measurement.subsets_per_second = ((measurement.subsets_per_second * measurement.runs) + subsets_per_second) / (measurement.runs + 1);
+            measurement.runs++;
+            found = true;
+        }
+
+        if (!found) {
+            throughput_measurement measurement = { max_set_value, subset_size, subsets_per_second, 1 };
+            model.measurements.push_back(measurement);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ *  The subsets per second expected for an M and N on the measured host.
+ */
+inline double predict_subsets_per_second(const throughput_model &model, const unsigned int max_set_value, const unsigned int subset_size) {
+    double cost = subset_cost(max_set_value, subset_size);
+
+    const throughput_measurement *nearest = NULL;
+    double nearest_distance = 0;
+    for (unsigned int i = 0; i < model.measurements.size(); i++) {
+        const throughput_measurement &measurement = model.measurements[i];
+        if (measurement.max_set_value == max_set_value && measurement.subset_size == subset_size) return measurement.subsets_per_second;
+
+        double distance = fabs(log(subset_cost(measurement.max_set_value, measurement.subset_size) / cost));
+        if (nearest == NULL || distance < nearest_distance) {
+            nearest = &measurement;
+            nearest_distance = distance;
+        }
+    }
+
+    if (nearest == NULL) return DEFAULT_WORD_SUBSETS_PER_SECOND / cost;
+    return nearest->subsets_per_second * (subset_cost(nearest->max_set_value, nearest->subset_size) / cost);
+}
+
+/**
+ *  How an (M, N) problem is split: slices of slice_size subsets (the last one has what's left), starting from rank 0.
+ */
+struct slice_plan {
+    unsigned int max_set_value;
+    unsigned int subset_size;
+    subset_rank_t total;
+    subset_rank_t slice_size;
+    subset_rank_t slices;
+    double subsets_per_second;
+};
+
+/**
+ *  Plans the slices for an M and N so each takes about target_seconds, returning false (with why in error) if the
+ *  problem can't be sliced.  A slice is at most 2^64 - 1 subsets, as that is all the client can test in one run.
+ *  init_binomials needs to have been called for M and N.
+ */
+inline bool plan_slices(const throughput_model &model, const unsigned int max_set_value, const unsigned int subset_size, const double target_seconds, slice_plan &plan, const char *&error) {
+    if (subset_size == 0 || max_set_value < subset_size) {
+        error = "N must be from 1 to M";
+        return false;
+    }
+
+    plan.max_set_value = max_set_value;
+    plan.subset_size = subset_size;
+    plan.total = n_choose_k(max_set_value - 1, subset_size - 1);
+    if (plan.total == MAX_RANK) {
+        error = "there are too many subsets to rank";
+        return false;
+    }
+
+    plan.subsets_per_second = predict_subsets_per_second(model, max_set_value, subset_size);
+
+    double ideal = plan.subsets_per_second * target_seconds;
+    subset_rank_t ideal_size = (ideal < 1) ? 1 : (ideal >= (double)ULLONG_MAX) ? ULLONG_MAX : (subset_rank_t)ideal;
+
+    /**
+     *  The slices are evened out, so the last one isn't a sliver.
+     */
+    plan.slices = (plan.total + ideal_size - 1) / ideal_size;
+    plan.slice_size = (plan.total + plan.slices - 1) / plan.slices;
+    return true;
+}
+
+/**
+ *  The number of subsets in the slice starting at first_rank (which is a multiple of slice_size).
+ */
+static inline subset_rank_t slice_count(const slice_plan &plan, const subset_rank_t first_rank) {
+    subset_rank_t remaining = plan.total - first_rank;
+    return (remaining < plan.slice_size) ? remaining : plan.slice_size;
+}
+
+/**
+ *  The client's arguments for a slice (its command line, and what its input file holds), and the name of its
+ *  workunit and input file, which is unique to the slice so a slice can't be made twice.
+ */
+static inline void slice_arguments(const slice_plan &plan, const subset_rank_t first_rank, const subset_rank_t count, char *arguments) {
+    char first_string[RANK_STRING_LENGTH], count_string[RANK_STRING_LENGTH];
+    sprintf(arguments, "%u %u %s %s", plan.max_set_value, plan.subset_size, rank_to_string(first_rank, first_string), rank_to_string(count, count_string));
+}
+
+static inline void slice_name(const char *app_name, const slice_plan &plan, const subset_rank_t first_rank, const subset_rank_t count, char *name) {
+    char first_string[RANK_STRING_LENGTH], count_string[RANK_STRING_LENGTH];
+    sprintf(name, "%s_%u_%u_%s_%s", app_name, plan.max_set_value, plan.subset_size, rank_to_string(first_rank, first_string), rank_to_string(count, count_string));
+}
+
+static inline double slice_seconds(const slice_plan &plan, const subset_rank_t count) {
+    return (double)count / plan.subsets_per_second;
+}
+
+static inline double slice_fpops(const slice_plan &plan, const subset_rank_t count, const double reference_fpops) {
+    return slice_seconds(plan, count) * reference_fpops;
+}
+
+#endif
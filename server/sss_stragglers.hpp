@@ -0,0 +1,90 @@
+#ifndef SSS_STRAGGLERS_HPP
+#define SSS_STRAGGLERS_HPP
+
+#include <vector>
+
+#include "sss_slices.hpp"
+
+/**
+ *  With slices which all take about as long, the last few to finish (on slow or busy hosts) decide when a whole
+ *  problem is done.  Once there are no new slices to hand out and some hosts are idle, a slice is late if, going by
+ *  its last checkpoint (how many of its subsets it had tested) and how long it has been going, it will finish more
+ *  than LATE_FACTOR times later than it would have on a typical host.  Its speed is taken as the subsets up to its
+ *  checkpoint over the whole time it has been going, so a host which has stopped checkpointing (eg it was turned off)
+ *  slows down the longer it is quiet.  The subsets after its checkpoint can then be split into sub-slices
+ *  (which the client runs like any other <i> <count>) for the idle hosts, each sized for its host's speed so they all
+ *  finish together, and the late slice is cut off at its checkpoint.  It is only split if that is projected to finish
+ *  at least SPLIT_MARGIN times sooner than leaving it, as the sub-slices have to start over from the checkpoint, and
+ *  host speeds are only estimates.
+ *
+ *  A slice with no checkpoint is treated as having tested nothing.  There is nothing to say how fast it is going, so
+ *  leaving it is taken to finish as soon as a typical host would from now, and it is only split between two or more
+ *  hosts (moving all of it to one host would only start it over).  Only typical rates measured from finished slices
+ *  should be used, and a slice (with the pieces split from it) is split at most MAX_SPLITS times, so a problem whose
+ *  slices are all slower than expected can't keep moving them around instead of finishing them.
+ *
+ *  sss_coordinator splits the slices of its workers this way, and simulate_stragglers measures how much sooner a
+ *  problem finishes with it.
+ */
+const double LATE_FACTOR = 1.5;
+const double SPLIT_MARGIN = 1.5;
+const unsigned int MAX_SPLITS = 4;
+
+/**
+ *  The subsets per second of a slice which checkpointed at done subsets and started elapsed seconds ago.
+ */
+static inline double slice_rate(const subset_rank_t done, const double elapsed) {
+    return (elapsed > 0) ? (double)done / elapsed : 0;
+}
+
+/**
+ *  Whether a slice of count subsets, started elapsed seconds ago and checkpointed at done subsets, will finish late
+ *  for a typical host testing typical_rate subsets per second.
+ */
+static inline bool slice_is_late(const subset_rank_t count, const subset_rank_t done, const double elapsed, const double typical_rate) {
+    double expected = (double)count / typical_rate;
+    double rate = slice_rate(done, elapsed);
+    if (rate <= 0) return elapsed > LATE_FACTOR * expected;
+
+    return elapsed + ((double)(count - done) / rate) > LATE_FACTOR * expected;
+}
+
+/**
+ *  Splits the remaining subsets (after a late slice's checkpoint) between helpers testing helper_rates subsets per
+ *  second, in proportion to their speed (every helper gets at least one subset, so there are at most remaining
+ *  helpers).  The late slice tests rate subsets per second (see slice_rate, 0 if it has no checkpoint), and a typical
+ *  host typical_rate.  Returns false, leaving counts empty, if it isn't worth splitting.
+ */
+inline bool plan_split(const subset_rank_t remaining, const double rate, const double typical_rate, const std::vector<double> &helper_rates, std::vector<subset_rank_t> &counts) {
+    counts.clear();
+    if (remaining == 0 || helper_rates.empty() || typical_rate <= 0) return false;
+
+    unsigned int helpers = helper_rates.size();
+    if ((subset_rank_t)helpers > remaining) helpers = (unsigned int)remaining;
+    if (rate <= 0 && helpers < 2) return false;
+
+    double total_rate = 0;
+    for (unsigned int i = 0; i < helpers; i++) total_rate += helper_rates[i];
+    if (total_rate <= 0) return false;
+
+    double keep_seconds = (double)remaining / ((rate > 0) ? rate : typical_rate);
+    double split_seconds = (double)remaining / total_rate;
+    if (split_seconds * SPLIT_MARGIN >= keep_seconds) return false;
+
+    /**
+     *  Each helper gets its share rounded down (but at least one subset), and the last one gets what's left.
+     */
+    subset_rank_t given = 0;
+    for (unsigned int i = 0; i + 1 < helpers; i++) {
+        subset_rank_t share = (subset_rank_t)((double)remaining * (helper_rates[i] / total_rate));
+        if (share == 0) share = 1;
+        if (share > remaining - given - (helpers - i - 1)) share = remaining - given - (helpers - i - 1);
+
+        counts.push_back(share);
+        given += share;
+    }
+    counts.push_back(remaining - given);
+    return true;
+}
+
+#endif
@@ -15,22 +15,40 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
 
-// sample_work_generator.cpp: an example BOINC work generator.
-// This work generator has the following properties
-// (you may need to change some or all of these):
+// sss_work_generator.cpp: the subset sum work generator,
+// based on the BOINC sample work generator.
+// This work generator has the following properties:
 //
-// - Runs as a daemon, and creates an unbounded supply of work.
-//   It attempts to maintain a "cushion" of 100 unsent job instances.
-//   (your app may not work this way; e.g. you might create work in batches)
-// - Creates work for the application "example_app".
-// - Creates a new input file for each job;
-//   the file (and the workunit names) contain a timestamp
-//   and sequence number, so they're unique.
+// - Runs as a daemon, and splits one (M, N) problem into slices
+//   (the <i> <count> of the client) which each take about
+//   --target_seconds on the host the throughput was measured on
+//   (see sss_slices.hpp).  It stops making work once every slice
+//   has been made.
+//   It keeps a cushion of unsent job instances, sized from how fast
+//   they are being handed out (see sss_cushion.hpp).
+// - Makes the jobs in batches: the input files are all written first,
+//   then the workunits are inserted a batch at a time
+//   (several rows per insert) in one transaction (see sss_jobs.hpp).
+// - Creates work for the application "subset_sum", passing the
+//   slice on the command line.
+// - The fpops estimate and bound of each job come from the same
+//   throughput model as the slice sizes.
+// - Creates a new input file for each job, holding its slice.
+//   The workunit names hold M, N and the slice, so they're unique,
+//   and a slice can't be made twice.
+// - Keeps how far it got in a state file, so it carries on from
+//   there when restarted.
 
 #include <unistd.h>
 #include <cstdlib>
 #include <string>
+#include <vector>
 #include <cstring>
+#include <ctime>
+
+#include "sss_slices.hpp"
+#include "sss_jobs.hpp"
+#include "sss_cushion.hpp"
 
 #include "boinc_db.h"
 #include "error_numbers.h"
@@ -44,30 +62,115 @@
 #include "sched_msgs.h"
 #include "str_util.h"
 
-#define CUSHION 10
-    // maintain at least this many unsent results
 #define REPLICATION_FACTOR  1
 
 const char* app_name = "subset_sum";
 const char* in_template_file = "subset_sum_in.xml";
 const char* out_template_file = "subset_sum_out.xml";
 
+const char* throughput_file = "kernel_benchmark.tsv";
+const char* state_file = "sss_work_generator_state.txt";
+unsigned int max_set_value = 0;
+unsigned int subset_size = 0;
+double target_seconds = 3600;
+double reference_fpops = 3e9;
+bool dry_run = false;
+int min_cushion = 10;
+int max_cushion = 100000;
+double lead_seconds = 600;
+int batch_size = 1000;
+
 char* in_template;
 DB_APP app;
-int start_time;
-int seqno;
+throughput_model model;
+slice_plan plan;
+subset_rank_t next_rank = 0;
+bool said_all_made = false;     // "Every slice has been made" is only logged once
+dispatch_cushion cushion;
+
+// Read how far the last run got (the first rank of the next slice),
+// if it was for the same M, N and slice size.
+// The slice size is kept from the state file,
+// so the slices line up even if the throughput has changed.
+//
+void read_state() {
+    FILE* f = fopen(config.project_path(state_file), "r");
+    if (!f) return;
+
+    char next_string[RANK_STRING_LENGTH], size_string[RANK_STRING_LENGTH];
+    unsigned int M, N;
+    subset_rank_t next, size;
+    if (fscanf(f, "%u %u %40s %40s", &M, &N, size_string, next_string) == 4
+        && parse_rank(size_string, size) && parse_rank(next_string, next)
+        && M == max_set_value && N == subset_size && size > 0 && next <= plan.total
+    ) {
+        plan.slice_size = size;
+        plan.slices = (plan.total + size - 1) / size;
+        next_rank = next;
+        log_messages.printf(MSG_NORMAL,
+            "Carrying on from subset %s (from %s)\n", next_string, state_file
+        );
+    }
+    fclose(f);
+}
+
+// Write the state to a temporary file, and rename it over the last one,
+// so there's always a whole state file.
+//
+int write_state() {
+    char path[1024], temp_path[1024 + 8];
+    char next_string[RANK_STRING_LENGTH], size_string[RANK_STRING_LENGTH];
+
+    strcpy(path, config.project_path(state_file));
+    sprintf(temp_path, "%s.tmp", path);
+
+    FILE* f = fopen(temp_path, "w");
+    if (!f) return ERR_FOPEN;
+    fprintf(f, "%u %u %s %s\n",
+        max_set_value, subset_size,
+        rank_to_string(plan.slice_size, size_string),
+        rank_to_string(next_rank, next_string)
+    );
+    if (fclose(f)) return ERR_FWRITE;
+    if (rename(temp_path, path)) return ERR_RENAME;
+    return 0;
+}
 
-// create one new job
+// If the last run made slices after it last wrote the state file
+// (if it stopped between committing a batch and writing the state),
+// skip over them.
 //
-int make_job() {
+int skip_made_slices() {
     DB_WORKUNIT wu;
-    char name[256], path[256];
+    char name[256], buf[512];
+    int retval;
+
+    while (next_rank < plan.total) {
+        slice_name(app_name, plan, next_rank, slice_count(plan, next_rank), name);
+        sprintf(buf, "where name='%s'", name);
+        retval = wu.lookup(buf);
+        if (retval == ERR_DB_NOT_FOUND) break;
+        if (retval) return retval;
+
+        log_messages.printf(MSG_NORMAL, "Slice %s was already made\n", name);
+        next_rank += slice_count(plan, next_rank);
+    }
+    return write_state();
+}
+
+// Write the input file for the slice starting at first_rank,
+// and add its workunit to values (for a batch insert)
+//
+int make_job(const subset_rank_t first_rank, std::string& values) {
+    DB_WORKUNIT wu;
+    char name[256], path[256], command_line[256];
     const char* infiles[1];
+    static char value_buf[MAX_QUERY_LEN];
     int retval;
 
-    // make a unique name (for the job and its input file)
-    //
-    sprintf(name, "%s_%d_%d", app_name, start_time, seqno++);
+    subset_rank_t count = slice_count(plan, first_rank);
+    slice_name(app_name, plan, first_rank, count, name);
+    slice_arguments(plan, first_rank, count, command_line);
 
     // Create the input file.
     // Put it at the right place in the download dir hierarchy
@@ -76,16 +179,16 @@ int make_job() {
     if (retval) return retval;
     FILE* f = fopen(path, "w");
     if (!f) return ERR_FOPEN;
-    fprintf(f, "This is the input file for job %s", name);
-    fclose(f);
+    fprintf(f, "%s\n", command_line);
+    if (fclose(f)) return ERR_FWRITE;
 
     // Fill in the job parameters
     //
     wu.clear();
     wu.appid = app.id;
     strcpy(wu.name, name);
-    wu.rsc_fpops_est = 1e12;
-    wu.rsc_fpops_bound = 1e14;
+    wu.rsc_fpops_est = slice_fpops(plan, count, reference_fpops);
+    wu.rsc_fpops_bound = wu.rsc_fpops_est * FPOPS_BOUND_FACTOR;
     wu.rsc_memory_bound = 1e8;
     wu.rsc_disk_bound = 1e8;
     wu.delay_bound = 86400;
@@ -96,18 +199,97 @@ int make_job() {
     wu.max_success_results = REPLICATION_FACTOR*4;
     infiles[0] = name;
 
-    // Register the job with BOINC
+    // Get the workunit's row, instead of inserting it
     //
     sprintf(path, "templates/%s", out_template_file);
-    return create_work(
+    retval = create_work(
         wu,
         in_template,
         path,
         config.project_path(path),
         infiles,
         1,
-        config
+        config,
+        command_line,
+        NULL,
+        value_buf
     );
+    if (retval) return retval;
+
+    if (!values.empty()) values += ",";
+    values += value_buf;
+    return 0;
+}
+
+// The BOINC database, for make_job_batch() (see sss_jobs.hpp)
+//
+struct boinc_jobs {
+    int make_job(const subset_rank_t first_rank, std::string& values) {
+        return ::make_job(first_rank, values);
+    }
+    int start_transaction() {
+        return boinc_db.start_transaction();
+    }
+    int insert_batch(std::string& values) {
+        DB_WORKUNIT wu;
+        return wu.insert_batch(values);
+    }
+    int commit_transaction() {
+        return boinc_db.commit_transaction();
+    }
+    int rollback_transaction() {
+        return boinc_db.rollback_transaction();
+    }
+};
+
+// Make up to njobs jobs (from next_rank), as one transaction.
+// If it fails part way, the transaction is rolled back,
+// so none of the batch is made (and the input files are
+// written again next time).
+//
+int make_jobs(int njobs) {
+    boinc_jobs jobs;
+    int retval;
+
+    retval = make_job_batch(jobs, plan, next_rank, njobs);
+    if (retval) return retval;
+    return write_state();
+}
+
+// Print the slices without making any work (--dry_run).
+//
+void print_plan() {
+    char total_string[RANK_STRING_LENGTH], size_string[RANK_STRING_LENGTH];
+    char slices_string[RANK_STRING_LENGTH], last_string[RANK_STRING_LENGTH];
+    subset_rank_t last_count = plan.total - ((plan.slices - 1) * plan.slice_size);
+
+    printf("%s subsets (sets of %u from 1..%u containing %u) at %.0lf subsets per second\n",
+        rank_to_string(plan.total, total_string), subset_size, max_set_value, max_set_value, plan.subsets_per_second
+    );
+    printf("%s slices of %s subsets (the last has %s), %.1lf seconds and %.3e fpops each\n",
+        rank_to_string(plan.slices, slices_string), rank_to_string(plan.slice_size, size_string),
+        rank_to_string(last_count, last_string),
+        slice_seconds(plan, plan.slice_size), slice_fpops(plan, plan.slice_size, reference_fpops)
+    );
+}
+
+// The unsent job instances, including the ones of workunits
+// the transitioner hasn't got to yet (which have no instances).
+//
+int count_unsent(int& n) {
+    DB_WORKUNIT wu;
+    char buf[256];
+    int retval, untransitioned;
+
+    retval = count_unsent_results(n, app.id);
+    if (retval) return retval;
+
+    sprintf(buf, "where appid=%lu and transition_time<=%d", (unsigned long)app.id, (int)time(0));
+    retval = wu.count(untransitioned, buf);
+    if (retval) return retval;
+
+    n += untransitioned*REPLICATION_FACTOR;
+    return 0;
 }
 
 void main_loop() {
@@ -116,52 +298,70 @@ void main_loop() {
     while (1) {
         check_stop_daemons();
         int n;
-        retval = count_unsent_results(n, 0);
+        retval = count_unsent(n);
         if (retval) {
             log_messages.printf(MSG_CRITICAL,
                 "count_unsent_jobs() failed: %s\n", boincerror(retval)
             );
             exit(retval);
         }
-        if (n > CUSHION) {
-            sleep(10);
-        } else {
-            int njobs = (CUSHION-n)/REPLICATION_FACTOR;
+        update_dispatch_rate(cushion, dtime(), n);
+
+        int target = cushion_jobs(cushion);
+        if (next_rank == plan.total) {
+            if (!said_all_made) {
+                log_messages.printf(MSG_NORMAL, "Every slice has been made\n");
+                said_all_made = true;
+            }
+        } else if (n < target) {
+            int njobs = (target-n)/REPLICATION_FACTOR;
+            if (njobs < 1) njobs = 1;
             log_messages.printf(MSG_DEBUG,
-                "Making %d jobs\n", njobs
+                "%d unsent, %.2f dispatched per second, making %d jobs\n",
+                n, cushion.jobs_per_second, njobs
             );
-            for (int i=0; i<njobs; i++) {
-                retval = make_job();
+            while (njobs > 0 && next_rank < plan.total) {
+                subset_rank_t first_rank = next_rank;
+                retval = make_jobs(njobs < batch_size ? njobs : batch_size);
                 if (retval) {
                     log_messages.printf(MSG_CRITICAL,
-                        "can't make job: %s\n", boincerror(retval)
+                        "can't make jobs: %s\n", boincerror(retval)
                     );
                     exit(retval);
                 }
+                int made = (int)((next_rank - first_rank + plan.slice_size - 1) / plan.slice_size);
+                n += made*REPLICATION_FACTOR;
+                njobs -= made;
             }
-            // Now sleep for a few seconds to let the transitioner
-            // create instances for the jobs we just created.
-            // Otherwise we could end up creating an excess of jobs.
-            sleep(5);
         }
+        end_dispatch_pass(cushion, dtime(), n);
+        boinc_sleep(poll_seconds(cushion, n));
     }
 }
 
 void usage(char *name) {
-    fprintf(stderr, "This is an example BOINC work generator.\n"
-        "This work generator has the following properties\n"
-        "(you may need to change some or all of these):\n"
-        "  It attempts to maintain a \"cushion\" of 100 unsent job instances.\n"
-        "  (your app may not work this way; e.g. you might create work in batches)\n"
-        "- Creates work for the application \"example_app\".\n"
-        "- Creates a new input file for each job;\n"
-        "  the file (and the workunit names) contain a timestamp\n"
-        "  and sequence number, so that they're unique.\n\n"
-        "Usage: %s [OPTION]...\n\n"
+    fprintf(stderr, "This is the subset sum work generator.\n"
+        "It splits the subsets of an (M, N) problem into slices which each\n"
+        "take about --target_seconds on the host the throughput was measured\n"
+        "on, and makes a job for each (keeping a cushion of unsent jobs,\n"
+        "sized from how fast they are being sent).\n\n"
+        "Usage: %s --max_set_value M --subset_size N [OPTION]...\n\n"
         "Options:\n"
-        "  [ --app X                Application name (default: example_app)\n"
-        "  [ --in_template_file     Input template (default: example_app_in)\n"
-        "  [ --out_template_file    Output template (default: example_app_out)\n"
+        "  [ --app X                Application name (default: subset_sum)\n"
+        "  [ --in_template_file     Input template (default: subset_sum_in.xml)\n"
+        "  [ --out_template_file    Output template (default: subset_sum_out.xml)\n"
+        "  [ --target_seconds X     Seconds each slice should take (default: 3600)\n"
+        "  [ --throughput_file X    Kernel benchmark with the measured throughput\n"
+        "                           (default: kernel_benchmark.tsv)\n"
+        "  [ --reference_fpops X    Floating point benchmark of the host the\n"
+        "                           throughput was measured on (default: 3e9)\n"
+        "  [ --state_file X         Where to keep how far it got\n"
+        "                           (default: sss_work_generator_state.txt)\n"
+        "  [ --dry_run              Print the slices instead of making work\n"
+        "  [ --lead_seconds X       Seconds of work to keep unsent (default: 600)\n"
+        "  [ --min_cushion N        Least unsent job instances to keep (default: 10)\n"
+        "  [ --max_cushion N        Most unsent job instances to keep (default: 100000)\n"
+        "  [ --batch_size N         Jobs made in each transaction (default: 1000)\n"
         "  [ -d X ]                 Sets debug level to X.\n"
         "  [ -h | --help ]          Shows this help text.\n"
         "  [ -v | --version ]       Shows version information.\n",
@@ -189,6 +389,28 @@ int main(int argc, char** argv) {
             in_template_file = argv[++i];
         } else if (!strcmp(argv[i], "--out_template_file")) {
             out_template_file = argv[++i];
+        } else if (!strcmp(argv[i], "--max_set_value")) {
+            max_set_value = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--subset_size")) {
+            subset_size = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--target_seconds")) {
+            target_seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--throughput_file")) {
+            throughput_file = argv[++i];
+        } else if (!strcmp(argv[i], "--reference_fpops")) {
+            reference_fpops = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--state_file")) {
+            state_file = argv[++i];
+        } else if (!strcmp(argv[i], "--dry_run")) {
+            dry_run = true;
+        } else if (!strcmp(argv[i], "--lead_seconds")) {
+            lead_seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--min_cushion")) {
+            min_cushion = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--max_cushion")) {
+            max_cushion = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--batch_size")) {
+            batch_size = atoi(argv[++i]);
         } else if (is_arg(argv[i], "h") || is_arg(argv[i], "help")) {
             usage(argv[0]);
             exit(0);
@@ -202,6 +424,32 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (max_set_value == 0 || subset_size == 0 || target_seconds <= 0 || reference_fpops <= 0
+        || lead_seconds <= 0 || min_cushion < 1 || batch_size < 1
+    ) {
+        log_messages.printf(MSG_CRITICAL, "--max_set_value and --subset_size are needed, and the seconds, fpops, cushion and batch size must be more than 0\n\n");
+        usage(argv[0]);
+        exit(1);
+    }
+
+    if (!read_throughput_file(throughput_file, model)) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't read the throughput from %s, using a rough guess\n", throughput_file
+        );
+    }
+
+    const char* error;
+    init_binomials(max_set_value - 1, subset_size - 1);
+    if (!plan_slices(model, max_set_value, subset_size, target_seconds, plan, error)) {
+        log_messages.printf(MSG_CRITICAL, "can't slice the sets of %u from 1..%u containing %u: %s\n", subset_size, max_set_value, max_set_value, error);
+        exit(1);
+    }
+
+    if (dry_run) {
+        print_plan();
+        exit(0);
+    }
+
     retval = config.parse_file();
     if (retval) {
         log_messages.printf(MSG_CRITICAL,
@@ -230,8 +478,15 @@ int main(int argc, char** argv) {
         exit(1);
     }
 
-    start_time = time(0);
-    seqno = 0;
+    read_state();
+    retval = skip_made_slices();
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't check for slices already made: %s\n", boincerror(retval)
+        );
+        exit(1);
+    }
+    init_dispatch_cushion(cushion, lead_seconds, min_cushion, max_cushion);
 
     log_messages.printf(MSG_NORMAL, "Starting\n");
 